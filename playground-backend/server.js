@@ -57,7 +57,9 @@ wss.on('connection', (ws) => {
             const exePath = fs.existsSync(linuxPath) ? linuxPath : localWinPath;
 
             try {
-                narutoProcess = spawn(exePath, [tempFile]);
+                // Buffer output between input() calls and cap it at 1 MB so chatty
+                // programs arrive in a few large chunks instead of one per line
+                narutoProcess = spawn(exePath, ['--flush=interactive', '--max-output=1048576', tempFile]);
 
                 narutoProcess.stdout.on('data', (output) => {
                     ws.send(JSON.stringify({ type: 'output', data: output.toString() }));
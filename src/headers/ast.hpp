@@ -5,6 +5,7 @@
 #include <vector>
 #include <unordered_map>
 #include "tokens.hpp" // Corrected
+#include "runtime_string.hpp"
 
 class AST_VISITOR;
 class CLASS_DECLARATION_STATEMENT;
@@ -13,20 +14,71 @@ class NEW_EXPRESSION;
 class GET_EXPRESSION;
 class SET_EXPRESSION;
 class SUPER_EXPRESSION;
+struct PIPELINE;
+
+// --- NODE KINDS ---
+// Every node records its concrete kind at construction so passes can
+// dispatch on shape with a plain switch instead of dynamic_cast.
+enum NODE_KIND
+{
+  // Expressions
+  NODE_LITERAL_EXPRESSION,
+  NODE_VARIABLE_EXPRESSION,
+  NODE_BINARY_EXPRESSION,
+  NODE_CONCAT_EXPRESSION,
+  NODE_BITWISE_EXPRESSION,
+  NODE_LOGICAL_EXPRESSION,
+  NODE_UNARY_EXPRESSION,
+  NODE_INCREMENT_EXPRESSION,
+  NODE_CALL_EXPRESSION,
+  NODE_INPUT_EXPRESSION,
+  NODE_ARRAY_LITERAL_EXPRESSION,
+  NODE_ARRAY_ACCESS_EXPRESSION,
+  NODE_ARRAY_ASSIGNMENT_EXPRESSION,
+  NODE_ASSIGNMENT_EXPRESSION,
+  NODE_COMPOUND_ASSIGNMENT_EXPRESSION,
+  NODE_NEW_EXPRESSION,
+  NODE_SUPER_EXPRESSION,
+  NODE_GET_EXPRESSION,
+  NODE_SET_EXPRESSION,
+
+  // Statements
+  NODE_EXPRESSION_STATEMENT,
+  NODE_PRINT_STATEMENT,
+  NODE_VARIABLE_DECLARATION_STATEMENT,
+  NODE_BLOCK_STATEMENT,
+  NODE_IF_STATEMENT,
+  NODE_SWITCH_STATEMENT,
+  NODE_WHILE_STATEMENT,
+  NODE_FOR_STATEMENT,
+  NODE_FOREACH_STATEMENT,
+  NODE_BREAK_STATEMENT,
+  NODE_CONTINUE_STATEMENT,
+  NODE_RETURN_STATEMENT,
+  NODE_FUNCTION_DECLARATION_STATEMENT,
+  NODE_CLASS_DECLARATION_STATEMENT,
+  NODE_STRUCT_DECLARATION_STATEMENT
+};
 
 // --- BASE CLASSES ---
 class AST_NODE
 {
 public:
+  const NODE_KIND kind;
+  AST_NODE(NODE_KIND k) : kind(k) {}
   virtual ~AST_NODE() = default;
   virtual void accept(AST_VISITOR *visitor) = 0;
 };
 
 class EXPRESSION : public AST_NODE
 {
+public:
+  EXPRESSION(NODE_KIND k) : AST_NODE(k) {}
 };
 class STATEMENT : public AST_NODE
 {
+public:
+  STATEMENT(NODE_KIND k) : AST_NODE(k) {}
 };
 
 // ==========================================
@@ -37,7 +89,12 @@ class LITERAL_EXPRESSION : public EXPRESSION
 {
 public:
   Token token;
-  LITERAL_EXPRESSION(Token t) : token(t) {}
+  RUNTIME_STRING text; // string and char literals: the text, interned once here
+  LITERAL_EXPRESSION(Token t) : EXPRESSION(NODE_LITERAL_EXPRESSION), token(t)
+  {
+    if (t.TYPE == TOKEN_STRING_LITERAL || t.TYPE == TOKEN_CHAR_LITERAL)
+      text = RUNTIME_STRING::intern(t.VALUE);
+  }
   void accept(AST_VISITOR *visitor) override;
 };
 
@@ -45,7 +102,7 @@ class VARIABLE_EXPRESSION : public EXPRESSION
 {
 public:
   Token name;
-  VARIABLE_EXPRESSION(Token n) : name(n) {}
+  VARIABLE_EXPRESSION(Token n) : EXPRESSION(NODE_VARIABLE_EXPRESSION), name(n) {}
   void accept(AST_VISITOR *visitor) override;
 };
 
@@ -56,8 +113,19 @@ public:
   EXPRESSION *left_operand;
   Token operator_token;
   EXPRESSION *right_operand;
+  bool is_string_concat = false; // set by TYPE_CHECKER when '+' yields a string
   BINARY_EXPRESSION(EXPRESSION *l, Token op, EXPRESSION *r)
-      : left_operand(l), operator_token(op), right_operand(r) {}
+      : EXPRESSION(NODE_BINARY_EXPRESSION), left_operand(l), operator_token(op), right_operand(r) {}
+  void accept(AST_VISITOR *visitor) override;
+};
+
+// N-ary string concatenation: "x=" + x + ", y=" + y
+// Built by the OPTIMIZER from left-nested string '+' chains.
+class CONCAT_EXPRESSION : public EXPRESSION
+{
+public:
+  std::vector<EXPRESSION *> parts;
+  CONCAT_EXPRESSION(std::vector<EXPRESSION *> p) : EXPRESSION(NODE_CONCAT_EXPRESSION), parts(p) {}
   void accept(AST_VISITOR *visitor) override;
 };
 
@@ -69,7 +137,7 @@ public:
   Token operator_token;
   EXPRESSION *right_operand;
   BITWISE_EXPRESSION(EXPRESSION *l, Token op, EXPRESSION *r)
-      : left_operand(l), operator_token(op), right_operand(r) {}
+      : EXPRESSION(NODE_BITWISE_EXPRESSION), left_operand(l), operator_token(op), right_operand(r) {}
   void accept(AST_VISITOR *visitor) override;
 };
 
@@ -81,7 +149,7 @@ public:
   Token operator_token;
   EXPRESSION *right_operand;
   LOGICAL_EXPRESSION(EXPRESSION *l, Token op, EXPRESSION *r)
-      : left_operand(l), operator_token(op), right_operand(r) {}
+      : EXPRESSION(NODE_LOGICAL_EXPRESSION), left_operand(l), operator_token(op), right_operand(r) {}
   void accept(AST_VISITOR *visitor) override;
 };
 
@@ -91,36 +159,65 @@ class UNARY_EXPRESSION : public EXPRESSION
 public:
   Token operator_token;
   EXPRESSION *right_operand;
-  UNARY_EXPRESSION(Token op, EXPRESSION *r) : operator_token(op), right_operand(r) {}
+  UNARY_EXPRESSION(Token op, EXPRESSION *r) : EXPRESSION(NODE_UNARY_EXPRESSION), operator_token(op), right_operand(r) {}
   void accept(AST_VISITOR *visitor) override;
 };
 
-// Increment/Decrement: ++i, i++
+// Increment/Decrement: ++i, i++, a[i]++, obj.count++
 class INCREMENT_EXPRESSION : public EXPRESSION
 {
 public:
-  EXPRESSION *variable;
+  EXPRESSION *variable; // any assignable target
   Token operator_token;
   bool is_prefix; // true = ++i, false = i++
   INCREMENT_EXPRESSION(EXPRESSION *v, Token op, bool prefix)
-      : variable(v), operator_token(op), is_prefix(prefix) {}
+      : EXPRESSION(NODE_INCREMENT_EXPRESSION), variable(v), operator_token(op), is_prefix(prefix) {}
   void accept(AST_VISITOR *visitor) override;
 };
 
 class CALL_EXPRESSION : public EXPRESSION
 {
 public:
+  // What the callee looks like, resolved once when the node is built:
+  // foo(...), obj.method(...), super(...) or anything else.
+  enum CALL_TARGET
+  {
+    CALL_FUNCTION,
+    CALL_METHOD,
+    CALL_SUPER,
+    CALL_UNKNOWN
+  };
   EXPRESSION *callee;
   std::vector<EXPRESSION *> arguments;
-  CALL_EXPRESSION(EXPRESSION *c, std::vector<EXPRESSION *> args) : callee(c), arguments(args) {}
+  CALL_TARGET target;
+  // Set by TYPE_CHECKER on the calls of a lazy pipeline, see pipeline.hpp:
+  // on a stream call the plan so far, on collect() / reduce() the whole one
+  PIPELINE *pipeline = nullptr;
+  CALL_EXPRESSION(EXPRESSION *c, std::vector<EXPRESSION *> args)
+      : EXPRESSION(NODE_CALL_EXPRESSION), callee(c), arguments(args), target(resolve_target(c)) {}
   void accept(AST_VISITOR *visitor) override;
+
+  static CALL_TARGET resolve_target(EXPRESSION *c)
+  {
+    switch (c->kind)
+    {
+    case NODE_VARIABLE_EXPRESSION:
+      return CALL_FUNCTION;
+    case NODE_GET_EXPRESSION:
+      return CALL_METHOD;
+    case NODE_SUPER_EXPRESSION:
+      return CALL_SUPER;
+    default:
+      return CALL_UNKNOWN;
+    }
+  }
 };
 
 class INPUT_EXPRESSION : public EXPRESSION
 {
 public:
   EXPRESSION *prompt_expression;
-  INPUT_EXPRESSION(EXPRESSION *p) : prompt_expression(p) {}
+  INPUT_EXPRESSION(EXPRESSION *p) : EXPRESSION(NODE_INPUT_EXPRESSION), prompt_expression(p) {}
   void accept(AST_VISITOR *visitor) override;
 };
 
@@ -128,7 +225,8 @@ class ARRAY_LITERAL_EXPRESSION : public EXPRESSION
 {
 public:
   std::vector<EXPRESSION *> elements;
-  ARRAY_LITERAL_EXPRESSION(std::vector<EXPRESSION *> e) : elements(e) {}
+  std::string element_type; // set by TYPE_CHECKER; "" for []
+  ARRAY_LITERAL_EXPRESSION(std::vector<EXPRESSION *> e) : EXPRESSION(NODE_ARRAY_LITERAL_EXPRESSION), elements(e) {}
   void accept(AST_VISITOR *visitor) override;
 };
 
@@ -137,7 +235,8 @@ class ARRAY_ACCESS_EXPRESSION : public EXPRESSION
 public:
   EXPRESSION *array_expression;
   EXPRESSION *index_expression;
-  ARRAY_ACCESS_EXPRESSION(EXPRESSION *arr, EXPRESSION *idx) : array_expression(arr), index_expression(idx) {}
+  bool in_bounds = false; // set by RANGE_ANALYSIS: v[i] with 0 <= i < v.length
+  ARRAY_ACCESS_EXPRESSION(EXPRESSION *arr, EXPRESSION *idx) : EXPRESSION(NODE_ARRAY_ACCESS_EXPRESSION), array_expression(arr), index_expression(idx) {}
   void accept(AST_VISITOR *visitor) override;
 };
 
@@ -147,8 +246,9 @@ public:
   EXPRESSION *array_expression;
   EXPRESSION *index_expression;
   EXPRESSION *value_expression;
+  bool in_bounds = false; // set by RANGE_ANALYSIS: v[i] with 0 <= i < v.length
   ARRAY_ASSIGNMENT_EXPRESSION(EXPRESSION *arr, EXPRESSION *idx, EXPRESSION *val)
-      : array_expression(arr), index_expression(idx), value_expression(val) {}
+      : EXPRESSION(NODE_ARRAY_ASSIGNMENT_EXPRESSION), array_expression(arr), index_expression(idx), value_expression(val) {}
   void accept(AST_VISITOR *visitor) override;
 };
 class ASSIGNMENT_EXPRESSION : public EXPRESSION
@@ -156,7 +256,23 @@ class ASSIGNMENT_EXPRESSION : public EXPRESSION
 public:
   Token variable_name;
   EXPRESSION *value_expression;
-  ASSIGNMENT_EXPRESSION(Token n, EXPRESSION *v) : variable_name(n), value_expression(v) {}
+  bool appends_to_target = false; // set by OPTIMIZER: s = s + ... appends to s in place
+  ASSIGNMENT_EXPRESSION(Token n, EXPRESSION *v) : EXPRESSION(NODE_ASSIGNMENT_EXPRESSION), variable_name(n), value_expression(v) {}
+  void accept(AST_VISITOR *visitor) override;
+};
+
+// Compound assignment: x += v, a[i] -= v, obj.f *= v
+// The target is evaluated once and updated in place. operator_token holds
+// the underlying binary/bitwise operator (+, -, &, ...), not the '+=' form.
+class COMPOUND_ASSIGNMENT_EXPRESSION : public EXPRESSION
+{
+public:
+  EXPRESSION *target;
+  Token operator_token;
+  EXPRESSION *value_expression;
+  bool appends_to_target = false; // set by OPTIMIZER: s += ... may append to s in place
+  COMPOUND_ASSIGNMENT_EXPRESSION(EXPRESSION *t, Token op, EXPRESSION *v)
+      : EXPRESSION(NODE_COMPOUND_ASSIGNMENT_EXPRESSION), target(t), operator_token(op), value_expression(v) {}
   void accept(AST_VISITOR *visitor) override;
 };
 
@@ -166,7 +282,7 @@ public:
   Token class_name;
   std::vector<EXPRESSION *> arguments;
   NEW_EXPRESSION(Token c, std::vector<EXPRESSION *> args)
-      : class_name(c), arguments(args) {}
+      : EXPRESSION(NODE_NEW_EXPRESSION), class_name(c), arguments(args) {}
   void accept(AST_VISITOR *visitor) override;
 };
 
@@ -174,7 +290,7 @@ class SUPER_EXPRESSION : public EXPRESSION
 {
 public:
   Token keyword;
-  SUPER_EXPRESSION(Token k) : keyword(k) {}
+  SUPER_EXPRESSION(Token k) : EXPRESSION(NODE_SUPER_EXPRESSION), keyword(k) {}
   void accept(AST_VISITOR *visitor) override;
 };
 
@@ -184,7 +300,7 @@ public:
   EXPRESSION *object_expression;
   Token member_name;
   GET_EXPRESSION(EXPRESSION *obj, Token mem)
-      : object_expression(obj), member_name(mem) {}
+      : EXPRESSION(NODE_GET_EXPRESSION), object_expression(obj), member_name(mem) {}
   void accept(AST_VISITOR *visitor) override;
 };
 
@@ -195,7 +311,7 @@ public:
   Token member_name;
   EXPRESSION *value_expression;
   SET_EXPRESSION(EXPRESSION *obj, Token mem, EXPRESSION *val)
-      : object_expression(obj), member_name(mem), value_expression(val) {}
+      : EXPRESSION(NODE_SET_EXPRESSION), object_expression(obj), member_name(mem), value_expression(val) {}
   void accept(AST_VISITOR *visitor) override;
 };
 
@@ -207,7 +323,7 @@ class EXPRESSION_STATEMENT : public STATEMENT
 {
 public:
   EXPRESSION *expression;
-  EXPRESSION_STATEMENT(EXPRESSION *e) : expression(e) {}
+  EXPRESSION_STATEMENT(EXPRESSION *e) : STATEMENT(NODE_EXPRESSION_STATEMENT), expression(e) {}
   void accept(AST_VISITOR *visitor) override;
 };
 
@@ -215,7 +331,7 @@ class PRINT_STATEMENT : public STATEMENT
 {
 public:
   EXPRESSION *expression;
-  PRINT_STATEMENT(EXPRESSION *e) : expression(e) {}
+  PRINT_STATEMENT(EXPRESSION *e) : STATEMENT(NODE_PRINT_STATEMENT), expression(e) {}
   void accept(AST_VISITOR *visitor) override;
 };
 
@@ -227,7 +343,7 @@ public:
   EXPRESSION *initializer_expression;
   bool is_constant;
   VARIABLE_DECLARATION_STATEMENT(Token t, Token n, EXPRESSION *init, bool c)
-      : type_token(t), name_token(n), initializer_expression(init), is_constant(c) {}
+      : STATEMENT(NODE_VARIABLE_DECLARATION_STATEMENT), type_token(t), name_token(n), initializer_expression(init), is_constant(c) {}
   void accept(AST_VISITOR *visitor) override;
 };
 
@@ -235,7 +351,7 @@ class BLOCK_STATEMENT : public STATEMENT
 {
 public:
   std::vector<STATEMENT *> statements;
-  BLOCK_STATEMENT(std::vector<STATEMENT *> s) : statements(s) {}
+  BLOCK_STATEMENT(std::vector<STATEMENT *> s) : STATEMENT(NODE_BLOCK_STATEMENT), statements(s) {}
   void accept(AST_VISITOR *visitor) override;
 };
 
@@ -245,7 +361,7 @@ public:
   EXPRESSION *condition_expression;
   STATEMENT *then_branch_statement;
   STATEMENT *else_branch_statement;
-  IF_STATEMENT(EXPRESSION *c, STATEMENT *t, STATEMENT *e) : condition_expression(c), then_branch_statement(t), else_branch_statement(e) {}
+  IF_STATEMENT(EXPRESSION *c, STATEMENT *t, STATEMENT *e) : STATEMENT(NODE_IF_STATEMENT), condition_expression(c), then_branch_statement(t), else_branch_statement(e) {}
   void accept(AST_VISITOR *visitor) override;
 };
 
@@ -260,7 +376,7 @@ public:
     std::vector<STATEMENT *> statements;
   };
   std::vector<CASE> cases;
-  SWITCH_STATEMENT(EXPRESSION *v, std::vector<CASE> c) : value(v), cases(c) {}
+  SWITCH_STATEMENT(EXPRESSION *v, std::vector<CASE> c) : STATEMENT(NODE_SWITCH_STATEMENT), value(v), cases(c) {}
   void accept(AST_VISITOR *visitor) override;
 };
 
@@ -269,10 +385,13 @@ class WHILE_STATEMENT : public STATEMENT
 public:
   EXPRESSION *condition_expression;
   STATEMENT *body_statement;
-  WHILE_STATEMENT(EXPRESSION *c, STATEMENT *b) : condition_expression(c), body_statement(b) {}
+  WHILE_STATEMENT(EXPRESSION *c, STATEMENT *b) : STATEMENT(NODE_WHILE_STATEMENT), condition_expression(c), body_statement(b) {}
   void accept(AST_VISITOR *visitor) override;
 };
 
+struct VECTOR_LOOP;
+struct PARALLEL_LOOP;
+
 class FOR_STATEMENT : public STATEMENT
 {
 public:
@@ -280,8 +399,31 @@ public:
   EXPRESSION *condition;
   EXPRESSION *increment;
   STATEMENT *body;
+  // Set by OPTIMIZER to +1 / -1 for a counted loop, for (int i = a; i < b; i++):
+  // an int declaration, i compared (<, <=, >, >=) with an int literal, a
+  // variable or v.length, and i++, i--, i += 1 or i = i - 1 as the increment
+  int counted_step = 0;
+  VECTOR_LOOP *vector_loop = nullptr; // set by OPTIMIZER, see vector_loop.hpp
+  PARALLEL_LOOP *parallel = nullptr;  // parallel for, see parallel_loop.hpp
   FOR_STATEMENT(STATEMENT *i, EXPRESSION *c, EXPRESSION *inc, STATEMENT *b)
-      : initializer(i), condition(c), increment(inc), body(b) {}
+      : STATEMENT(NODE_FOR_STATEMENT), initializer(i), condition(c), increment(inc), body(b) {}
+  void accept(AST_VISITOR *visitor) override;
+};
+
+// for (T x : collection). The collection is an array (its elements), a
+// string (one-character strings), a map (its keys, in insertion order) or
+// a lazy pipeline such as range(a, b[, step]), which counts from a up to b
+// without building an array.
+class FOREACH_STATEMENT : public STATEMENT
+{
+public:
+  Token type_token;
+  Token name_token;
+  EXPRESSION *collection;
+  STATEMENT *body;
+  PIPELINE *pipeline = nullptr; // set by TYPE_CHECKER when collection is a lazy pipeline
+  FOREACH_STATEMENT(Token t, Token n, EXPRESSION *c, STATEMENT *b)
+      : STATEMENT(NODE_FOREACH_STATEMENT), type_token(t), name_token(n), collection(c), body(b) {}
   void accept(AST_VISITOR *visitor) override;
 };
 
@@ -290,7 +432,7 @@ class BREAK_STATEMENT : public STATEMENT
 {
 public:
   Token keyword;
-  BREAK_STATEMENT(Token k) : keyword(k) {}
+  BREAK_STATEMENT(Token k) : STATEMENT(NODE_BREAK_STATEMENT), keyword(k) {}
   void accept(AST_VISITOR *visitor) override;
 };
 
@@ -298,7 +440,7 @@ class CONTINUE_STATEMENT : public STATEMENT
 {
 public:
   Token keyword;
-  CONTINUE_STATEMENT(Token k) : keyword(k) {}
+  CONTINUE_STATEMENT(Token k) : STATEMENT(NODE_CONTINUE_STATEMENT), keyword(k) {}
   void accept(AST_VISITOR *visitor) override;
 };
 
@@ -307,7 +449,7 @@ class RETURN_STATEMENT : public STATEMENT
 public:
   Token keyword_token;
   EXPRESSION *value_expression;
-  RETURN_STATEMENT(Token k, EXPRESSION *v) : keyword_token(k), value_expression(v) {}
+  RETURN_STATEMENT(Token k, EXPRESSION *v) : STATEMENT(NODE_RETURN_STATEMENT), keyword_token(k), value_expression(v) {}
   void accept(AST_VISITOR *visitor) override;
 };
 
@@ -324,7 +466,7 @@ public:
   std::vector<PARAMETER_NODE> parameters;
   BLOCK_STATEMENT *body_block;
   FUNCTION_DECLARATION_STATEMENT(Token n, Token r, std::vector<PARAMETER_NODE> p, BLOCK_STATEMENT *b)
-      : name_token(n), return_type_token(r), parameters(p), body_block(b) {}
+      : STATEMENT(NODE_FUNCTION_DECLARATION_STATEMENT), name_token(n), return_type_token(r), parameters(p), body_block(b) {}
   void accept(AST_VISITOR *visitor) override;
 };
 
@@ -339,7 +481,7 @@ public:
   CLASS_DECLARATION_STATEMENT(Token n, Token s,
                               std::vector<VARIABLE_DECLARATION_STATEMENT *> f,
                               std::vector<FUNCTION_DECLARATION_STATEMENT *> m)
-      : name_token(n), superclass_token(s), fields(f), methods(m) {}
+      : STATEMENT(NODE_CLASS_DECLARATION_STATEMENT), name_token(n), superclass_token(s), fields(f), methods(m) {}
   void accept(AST_VISITOR *visitor) override;
 };
 
@@ -349,7 +491,7 @@ public:
   Token name_token;
   std::vector<VARIABLE_DECLARATION_STATEMENT *> fields;
   STRUCT_DECLARATION_STATEMENT(Token n, std::vector<VARIABLE_DECLARATION_STATEMENT *> f)
-      : name_token(n), fields(f) {}
+      : STATEMENT(NODE_STRUCT_DECLARATION_STATEMENT), name_token(n), fields(f) {}
   void accept(AST_VISITOR *visitor) override;
 };
 
@@ -362,6 +504,7 @@ public:
   virtual void visit(LITERAL_EXPRESSION *expression) = 0;
   virtual void visit(VARIABLE_EXPRESSION *expression) = 0;
   virtual void visit(BINARY_EXPRESSION *expression) = 0;
+  virtual void visit(CONCAT_EXPRESSION *expression) = 0;
   virtual void visit(BITWISE_EXPRESSION *expression) = 0;
   virtual void visit(LOGICAL_EXPRESSION *expression) = 0;
   virtual void visit(UNARY_EXPRESSION *expression) = 0;
@@ -372,6 +515,7 @@ public:
   virtual void visit(ARRAY_ACCESS_EXPRESSION *expression) = 0;
   virtual void visit(ARRAY_ASSIGNMENT_EXPRESSION *expression) = 0;
   virtual void visit(ASSIGNMENT_EXPRESSION *expression) = 0;
+  virtual void visit(COMPOUND_ASSIGNMENT_EXPRESSION *expression) = 0;
   virtual void visit(NEW_EXPRESSION *expression) = 0;
   virtual void visit(SUPER_EXPRESSION *expression) = 0;
   virtual void visit(GET_EXPRESSION *expression) = 0;
@@ -385,6 +529,7 @@ public:
   virtual void visit(SWITCH_STATEMENT *statement) = 0;
   virtual void visit(WHILE_STATEMENT *statement) = 0;
   virtual void visit(FOR_STATEMENT *statement) = 0;
+  virtual void visit(FOREACH_STATEMENT *statement) = 0;
   virtual void visit(BREAK_STATEMENT *statement) = 0;
   virtual void visit(CONTINUE_STATEMENT *statement) = 0;
   virtual void visit(RETURN_STATEMENT *statement) = 0;
@@ -397,6 +542,7 @@ public:
 inline void LITERAL_EXPRESSION::accept(AST_VISITOR *v) { v->visit(this); }
 inline void VARIABLE_EXPRESSION::accept(AST_VISITOR *v) { v->visit(this); }
 inline void BINARY_EXPRESSION::accept(AST_VISITOR *v) { v->visit(this); }
+inline void CONCAT_EXPRESSION::accept(AST_VISITOR *v) { v->visit(this); }
 inline void BITWISE_EXPRESSION::accept(AST_VISITOR *v) { v->visit(this); }
 inline void LOGICAL_EXPRESSION::accept(AST_VISITOR *v) { v->visit(this); }
 inline void UNARY_EXPRESSION::accept(AST_VISITOR *v) { v->visit(this); }
@@ -407,6 +553,7 @@ inline void ARRAY_LITERAL_EXPRESSION::accept(AST_VISITOR *v) { v->visit(this); }
 inline void ARRAY_ACCESS_EXPRESSION::accept(AST_VISITOR *v) { v->visit(this); }
 inline void ARRAY_ASSIGNMENT_EXPRESSION::accept(AST_VISITOR *v) { v->visit(this); }
 inline void ASSIGNMENT_EXPRESSION::accept(AST_VISITOR *v) { v->visit(this); }
+inline void COMPOUND_ASSIGNMENT_EXPRESSION::accept(AST_VISITOR *v) { v->visit(this); }
 inline void NEW_EXPRESSION::accept(AST_VISITOR *v) { v->visit(this); }
 inline void SUPER_EXPRESSION::accept(AST_VISITOR *v) { v->visit(this); }
 inline void GET_EXPRESSION::accept(AST_VISITOR *v) { v->visit(this); }
@@ -419,6 +566,7 @@ inline void IF_STATEMENT::accept(AST_VISITOR *v) { v->visit(this); }
 inline void SWITCH_STATEMENT::accept(AST_VISITOR *v) { v->visit(this); }
 inline void WHILE_STATEMENT::accept(AST_VISITOR *v) { v->visit(this); }
 inline void FOR_STATEMENT::accept(AST_VISITOR *v) { v->visit(this); }
+inline void FOREACH_STATEMENT::accept(AST_VISITOR *v) { v->visit(this); }
 inline void BREAK_STATEMENT::accept(AST_VISITOR *v) { v->visit(this); }
 inline void CONTINUE_STATEMENT::accept(AST_VISITOR *v) { v->visit(this); }
 inline void RETURN_STATEMENT::accept(AST_VISITOR *v) { v->visit(this); }
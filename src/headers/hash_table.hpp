@@ -0,0 +1,159 @@
+#ifndef __HASH_TABLE_H
+#define __HASH_TABLE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+// Open-addressing index behind map<K, V> (see RuntimeMap), laid out like a
+// Swiss table. The entries themselves live elsewhere, in insertion order;
+// the index only maps a hash to entry numbers:
+//   - one control byte per slot: EMPTY, DELETED, or the low 7 bits of the
+//     hash of the entry in it (H2);
+//   - slots come in groups of GROUP; the rest of the hash (H1) picks the
+//     first group to probe, and later groups follow a triangular sequence;
+//   - a lookup tests a whole group of control bytes at once (one SSE2
+//     compare, or a byte loop in other builds) and only looks at the
+//     entries whose H2 matches, which is rarely more than one;
+//   - a group with an EMPTY byte ends the probe.
+// Removed entries leave DELETED bytes behind; insert() refuses once live
+// plus deleted slots pass 7/8 of the table, and the owner rebuilds it.
+class HASH_INDEX
+{
+public:
+  static constexpr size_t GROUP = 16;
+  static constexpr uint32_t NONE = 0xFFFFFFFF;
+
+  // splitmix64's finalizer: every bit of x reaches H1 and H2
+  static size_t mix(unsigned long long x)
+  {
+    x ^= x >> 30;
+    x *= 0xbf58476d1ce4e5b9ULL;
+    x ^= x >> 27;
+    x *= 0x94d049bb133111ebULL;
+    x ^= x >> 31;
+    return (size_t)x;
+  }
+
+  // Empties the index and sizes it for 'entries' entries
+  void reset(size_t entries)
+  {
+    size_t capacity = GROUP;
+    while (capacity * 7 / 8 < entries + 1)
+      capacity *= 2;
+    control.assign(capacity, EMPTY);
+    slots.assign(capacity, NONE);
+    used = 0;
+  }
+
+  // The entry filed under hash for which matches(entry) holds, or NONE
+  template <typename MATCHES>
+  uint32_t find(size_t hash, MATCHES matches) const
+  {
+    size_t position = locate(hash, matches);
+    return position == NOT_FOUND ? NONE : slots[position];
+  }
+
+  // Files a new entry under hash, which must not be in the index yet.
+  // False (nothing filed) when the table is too full; reset() it first.
+  bool insert(size_t hash, uint32_t entry)
+  {
+    if ((used + 1) * 8 > control.size() * 7)
+      return false;
+    size_t mask = control.size() / GROUP - 1;
+    size_t group = (hash >> 7) & mask;
+    for (size_t step = 1;; step++)
+    {
+      unsigned free = match_free(&control[group * GROUP]);
+      if (free)
+      {
+        size_t position = group * GROUP + __builtin_ctz(free);
+        if (control[position] == EMPTY)
+          used++;
+        control[position] = h2(hash);
+        slots[position] = entry;
+        return true;
+      }
+      group = (group + step) & mask;
+    }
+  }
+
+  // Drops the entry filed under hash for which matches(entry) holds;
+  // that entry, or NONE
+  template <typename MATCHES>
+  uint32_t erase(size_t hash, MATCHES matches)
+  {
+    size_t position = locate(hash, matches);
+    if (position == NOT_FOUND)
+      return NONE;
+    control[position] = DELETED;
+    return slots[position];
+  }
+
+private:
+  static constexpr unsigned char EMPTY = 0x80;
+  static constexpr unsigned char DELETED = 0xFE;
+  static constexpr size_t NOT_FOUND = (size_t)-1;
+
+  std::vector<unsigned char> control; // a multiple of GROUP bytes, or none yet
+  std::vector<uint32_t> slots;
+  size_t used = 0; // slots that are not EMPTY (live or DELETED)
+
+  static unsigned char h2(size_t hash) { return (unsigned char)(hash & 0x7F); }
+
+  template <typename MATCHES>
+  size_t locate(size_t hash, MATCHES matches) const
+  {
+    if (control.empty())
+      return NOT_FOUND;
+    size_t mask = control.size() / GROUP - 1;
+    size_t group = (hash >> 7) & mask;
+    for (size_t step = 1;; step++)
+    {
+      const unsigned char *bytes = &control[group * GROUP];
+      for (unsigned hits = match_byte(bytes, h2(hash)); hits; hits &= hits - 1)
+      {
+        size_t position = group * GROUP + __builtin_ctz(hits);
+        if (matches(slots[position]))
+          return position;
+      }
+      if (match_byte(bytes, EMPTY))
+        return NOT_FOUND;
+      group = (group + step) & mask;
+    }
+  }
+
+  // Bit i set when byte i of the group equals 'byte'
+  static unsigned match_byte(const unsigned char *group, unsigned char byte)
+  {
+#if defined(__SSE2__)
+    __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i *>(group));
+    return (unsigned)_mm_movemask_epi8(_mm_cmpeq_epi8(bytes, _mm_set1_epi8((char)byte)));
+#else
+    unsigned hits = 0;
+    for (size_t i = 0; i < GROUP; i++)
+      if (group[i] == byte)
+        hits |= 1u << i;
+    return hits;
+#endif
+  }
+
+  // Bit i set when slot i is EMPTY or DELETED (the bytes with the top bit)
+  static unsigned match_free(const unsigned char *group)
+  {
+#if defined(__SSE2__)
+    return (unsigned)_mm_movemask_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i *>(group)));
+#else
+    unsigned hits = 0;
+    for (size_t i = 0; i < GROUP; i++)
+      if (group[i] & 0x80)
+        hits |= 1u << i;
+    return hits;
+#endif
+  }
+};
+
+#endif
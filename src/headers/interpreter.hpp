@@ -2,16 +2,39 @@
 #define __INTERPRETER_H
 
 #include "ast.hpp" // Corrected Include
+#include "number_format.hpp"
+#include "output_writer.hpp"
+#include "line_reader.hpp"
+#include "numeric_loader.hpp"
+#include "text_search.hpp"
+#include "vector_kernels.hpp"
+#include "matrix_kernels.hpp"
+#include "vector_loop.hpp"
+#include "pipeline.hpp"
+#include "parallel_loop.hpp"
+#include "work_stealing_pool.hpp"
+#include "runtime_string.hpp"
+#include "hash_table.hpp"
+#include <charconv>
+#include <cctype>
+#include <type_traits>
 #include <iostream>
+#include <sstream>
 #include <unordered_map>
 #include <vector>
 #include <string>
 #include <cmath>
 #include <algorithm> // for std::stol
 #include <memory>
+#include <string_view>
+#include <climits>
+#include <cstring>
+#include <new>
+#include <stdexcept>
 
 class RuntimeObject;
 class RuntimeStruct;
+class RuntimeMap;
 
 struct RuntimeValue
 {
@@ -24,15 +47,85 @@ struct RuntimeValue
     VOID,
     ARRAY,
     OBJECT,
-    STRUCT
+    STRUCT,
+    MAP
   } type;
   long long int_val = 0;
   double float_val = 0.0;
-  std::string string_val = "";
+  RUNTIME_STRING string_val; // refcounted, O(1) to copy
   bool bool_val = false;
-  std::vector<RuntimeValue> array_elements;
+
+  // Arrays whose static element type is primitive keep their elements
+  // unboxed; strings, objects and nested arrays stay boxed. A typed array
+  // falls back to boxed storage if a value it cannot hold is stored into it.
+  enum ArrayStorage
+  {
+    BOXED,
+    INT_ELEMENTS,   // int, short, long
+    FLOAT_ELEMENTS, // float, double
+    BOOL_ELEMENTS,  // packed bits
+    BYTE_ELEMENTS   // one byte each, values 0..255
+  };
+
+  // Everything an array holds lives behind one pointer, so scalars stay
+  // small. The pointer owns it: copying a value copies its array, as
+  // before (views are how copies share elements, see VIEWS below).
+  struct ArrayData
+  {
+    ArrayStorage array_storage = BOXED;
+    std::vector<RuntimeValue> array_elements;
+    std::vector<long long> int_elements;
+    std::vector<double> float_elements;
+    std::vector<bool> bool_elements;
+    std::vector<unsigned char> byte_elements;
+    size_t grid_rows = 0, grid_columns = 0; // see GRIDS below
+    bool sparse = false;                     // see SPARSE ARRAYS below
+    size_t sparse_length = 0;
+    std::unordered_map<size_t, size_t> sparse_slots;
+    ArrayStorage sparse_fill = BOXED;
+    size_t dense_checked = 0; // length when array_expand last counted
+    std::shared_ptr<RuntimeValue> view_source = nullptr; // see VIEWS below
+    size_t view_offset = 0, view_length = 0;
+  };
+
+  class ArrayPointer
+  {
+    std::unique_ptr<ArrayData> data;
+
+  public:
+    ArrayPointer() = default;
+    ArrayPointer(const ArrayPointer &other) : data(other.data ? new ArrayData(*other.data) : nullptr) {}
+    ArrayPointer(ArrayPointer &&other) noexcept = default;
+    ArrayPointer &operator=(const ArrayPointer &other)
+    {
+      if (this != &other)
+        data.reset(other.data ? new ArrayData(*other.data) : nullptr);
+      return *this;
+    }
+    ArrayPointer &operator=(ArrayPointer &&other) noexcept = default;
+
+    ArrayData *get() const { return data.get(); }
+    void create() { data.reset(new ArrayData()); }
+  };
+  ArrayPointer array_data;
+
+  // The array state, created on first write; values that are not arrays
+  // read an empty one
+  ArrayData &array()
+  {
+    if (!array_data.get())
+      array_data.create();
+    return *array_data.get();
+  }
+  const ArrayData &array() const
+  {
+    static const ArrayData empty;
+    return array_data.get() ? *array_data.get() : empty;
+  }
+
   std::shared_ptr<RuntimeObject> object_val = nullptr;
   std::shared_ptr<RuntimeStruct> struct_val = nullptr;
+  std::shared_ptr<RuntimeMap> map_val = nullptr; // shared until written, see RuntimeMap
 
   static RuntimeValue Integer(long long v)
   {
@@ -48,11 +141,11 @@ struct RuntimeValue
     r.float_val = v;
     return r;
   }
-  static RuntimeValue String(std::string v)
+  static RuntimeValue String(RUNTIME_STRING v)
   {
     RuntimeValue r;
     r.type = STRING;
-    r.string_val = v;
+    r.string_val = std::move(v);
     return r;
   }
   static RuntimeValue Bool(bool v)
@@ -72,10 +165,552 @@ struct RuntimeValue
   {
     RuntimeValue r;
     r.type = ARRAY;
-    r.array_elements = v;
+    r.array().array_elements = std::move(v);
+    return r;
+  }
+  // Empty array with the given storage
+  static RuntimeValue TypedArray(ArrayStorage storage)
+  {
+    RuntimeValue r;
+    r.type = ARRAY;
+    r.array().array_storage = storage;
     return r;
   }
+  static RuntimeValue Map(ArrayStorage storage);
   static RuntimeValue copy_value(RuntimeValue val);
+
+  // Storage for a declared element type ("int" for int[])
+  static ArrayStorage storage_for(const std::string &element_type)
+  {
+    if (element_type == "int" || element_type == "short" || element_type == "long")
+      return INT_ELEMENTS;
+    if (element_type == "float" || element_type == "double")
+      return FLOAT_ELEMENTS;
+    if (element_type == "bool")
+      return BOOL_ELEMENTS;
+    if (element_type == "byte")
+      return BYTE_ELEMENTS;
+    return BOXED;
+  }
+
+  // --- SLOTS ---
+  // The unboxed vectors (or array_elements) viewed as one list of slots.
+  // A grid keeps all its cells here, a sparse array the elements written
+  // so far, any other array its elements.
+  size_t slot_count() const
+  {
+    switch (array().array_storage)
+    {
+    case INT_ELEMENTS:
+      return array().int_elements.size();
+    case FLOAT_ELEMENTS:
+      return array().float_elements.size();
+    case BOOL_ELEMENTS:
+      return array().bool_elements.size();
+    case BYTE_ELEMENTS:
+      return array().byte_elements.size();
+    default:
+      return array().array_elements.size();
+    }
+  }
+
+  RuntimeValue slot_get(size_t i) const
+  {
+    switch (array().array_storage)
+    {
+    case INT_ELEMENTS:
+      return Integer(array().int_elements[i]);
+    case FLOAT_ELEMENTS:
+      return Float(array().float_elements[i]);
+    case BOOL_ELEMENTS:
+      return Bool(array().bool_elements[i]);
+    case BYTE_ELEMENTS:
+      return Integer(array().byte_elements[i]);
+    default:
+      return array().array_elements[i];
+    }
+  }
+
+  // Caller checks storage_accepts(v) first
+  void slot_set(size_t i, const RuntimeValue &v)
+  {
+    switch (array().array_storage)
+    {
+    case INT_ELEMENTS:
+      array().int_elements[i] = v.int_val;
+      break;
+    case FLOAT_ELEMENTS:
+      array().float_elements[i] = v.type == INT ? (double)v.int_val : v.float_val;
+      break;
+    case BOOL_ELEMENTS:
+      array().bool_elements[i] = v.bool_val;
+      break;
+    case BYTE_ELEMENTS:
+      array().byte_elements[i] = (unsigned char)v.int_val;
+      break;
+    default:
+      array().array_elements[i] = v;
+    }
+  }
+
+  // New slots hold the element type's zero (Void when boxed)
+  void slot_resize(size_t n)
+  {
+    switch (array().array_storage)
+    {
+    case INT_ELEMENTS:
+      array().int_elements.resize(n, 0);
+      break;
+    case FLOAT_ELEMENTS:
+      array().float_elements.resize(n, 0.0);
+      break;
+    case BOOL_ELEMENTS:
+      array().bool_elements.resize(n, false);
+      break;
+    case BYTE_ELEMENTS:
+      array().byte_elements.resize(n, 0);
+      break;
+    default:
+      array().array_elements.resize(n, Void());
+    }
+  }
+
+  // Whether an unboxed slot of this storage holds v without changing it
+  bool storage_accepts(const RuntimeValue &v) const
+  {
+    switch (array().array_storage)
+    {
+    case INT_ELEMENTS:
+      return v.type == INT;
+    case FLOAT_ELEMENTS:
+      return v.type == FLOAT || v.type == INT; // widened, as declared
+    case BOOL_ELEMENTS:
+      return v.type == BOOL;
+    case BYTE_ELEMENTS:
+      return v.type == INT && v.int_val >= 0 && v.int_val <= 255;
+    default:
+      return true;
+    }
+  }
+
+  // --- SPARSE ARRAYS ---
+  // Writes far past the end (a[1000000000] = 1, or a[i * 4000] = 1 in a
+  // loop) do not allocate the gaps. Once the array would be less than about
+  // half written it turns sparse instead: the slots hold only the elements
+  // written, in write order, and sparse_slots maps each index to its slot.
+  // Every other index is a hole that reads as the zero of sparse_fill (the
+  // storage the array had when it turned sparse). Once at least half of
+  // sparse_length has been written it is dense again.
+  static constexpr size_t SPARSE_GAP = 4096; // slack filled densely
+
+  RuntimeValue hole_value() const
+  {
+    switch (array().sparse_fill)
+    {
+    case INT_ELEMENTS:
+    case BYTE_ELEMENTS:
+      return Integer(0);
+    case FLOAT_ELEMENTS:
+      return Float(0.0);
+    case BOOL_ELEMENTS:
+      return Bool(false);
+    default:
+      return Void();
+    }
+  }
+
+  // A slot holding the zero of its storage reads the same as a hole
+  bool is_hole(const RuntimeValue &v) const
+  {
+    switch (array().array_storage)
+    {
+    case INT_ELEMENTS:
+    case BYTE_ELEMENTS:
+      return v.int_val == 0;
+    case FLOAT_ELEMENTS:
+      return v.float_val == 0.0 && !std::signbit(v.float_val);
+    case BOOL_ELEMENTS:
+      return !v.bool_val;
+    default:
+      return v.type == VOID;
+    }
+  }
+
+  size_t written_count() const
+  {
+    size_t count = slot_count(), written = 0;
+    for (size_t i = 0; i < count; i++)
+      written += !is_hole(slot_get(i));
+    return written;
+  }
+
+  // Only the slots that are not holes are kept
+  void make_sparse(size_t length)
+  {
+    RuntimeValue packed = TypedArray(array().array_storage);
+    size_t count = slot_count();
+    for (size_t i = 0; i < count; i++)
+    {
+      RuntimeValue v = slot_get(i);
+      if (is_hole(v))
+        continue;
+      size_t slot = packed.slot_count();
+      packed.slot_resize(slot + 1);
+      packed.slot_set(slot, v);
+      packed.array().sparse_slots[i] = slot;
+    }
+    packed.array().sparse = true;
+    packed.array().sparse_length = length;
+    packed.array().sparse_fill = packed.array().array_storage;
+    *this = std::move(packed);
+  }
+
+  void make_dense()
+  {
+    RuntimeValue dense = TypedArray(array().array_storage);
+    dense.slot_resize(array().sparse_length);
+    if (array().array_storage == BOXED && array().sparse_fill != BOXED)
+      for (size_t i = 0; i < array().sparse_length; i++)
+        dense.slot_set(i, hole_value());
+    for (auto &entry : array().sparse_slots)
+      dense.slot_set(entry.first, slot_get(entry.second));
+    dense.array().dense_checked = array().sparse_length;
+    *this = std::move(dense);
+  }
+
+  // --- FLAT STORAGE ---
+  // Elements by index, whether dense, sparse or a view. Only reads see
+  // through a view; writers unshare() first.
+  size_t flat_length() const { return is_view() ? array().view_length : array().sparse ? array().sparse_length : slot_count(); }
+
+  RuntimeValue flat_get(size_t i) const
+  {
+    if (is_view())
+      return array().view_source->flat_get(array().view_offset + i);
+    if (!array().sparse)
+      return slot_get(i);
+    auto found = array().sparse_slots.find(i);
+    return found == array().sparse_slots.end() ? hole_value() : slot_get(found->second);
+  }
+
+  // Caller checks storage_accepts(v) first
+  void flat_set(size_t i, const RuntimeValue &v)
+  {
+    if (!array().sparse)
+    {
+      slot_set(i, v);
+      return;
+    }
+    auto found = array().sparse_slots.find(i);
+    if (found != array().sparse_slots.end())
+    {
+      slot_set(found->second, v);
+      return;
+    }
+    size_t slot = slot_count();
+    slot_resize(slot + 1);
+    slot_set(slot, v);
+    array().sparse_slots[i] = slot;
+    if (array().sparse_slots.size() * 2 >= array().sparse_length)
+      make_dense();
+  }
+
+  // New elements hold the element type's zero (Void when boxed)
+  void flat_resize(size_t n)
+  {
+    if (!array().sparse)
+    {
+      slot_resize(n);
+      return;
+    }
+    if (n < array().sparse_length)
+    {
+      // Keep only the elements below the new length
+      std::vector<std::pair<size_t, RuntimeValue>> kept;
+      for (auto &entry : array().sparse_slots)
+        if (entry.first < n)
+          kept.push_back({entry.first, slot_get(entry.second)});
+      slot_resize(0);
+      array().sparse_slots.clear();
+      for (auto &entry : kept)
+      {
+        array().sparse_slots[entry.first] = slot_count();
+        slot_resize(slot_count() + 1);
+        slot_set(slot_count() - 1, entry.second);
+      }
+    }
+    array().sparse_length = n;
+  }
+
+  // Boxed element i in place, or nullptr for a hole of a sparse array
+  RuntimeValue *element_slot(size_t i)
+  {
+    unshare();
+    if (!array().sparse)
+      return &array().array_elements[i];
+    auto found = array().sparse_slots.find(i);
+    return found == array().sparse_slots.end() ? nullptr : &array().array_elements[found->second];
+  }
+
+  const RuntimeValue *element_slot(size_t i) const
+  {
+    if (is_view())
+      return array().view_source->element_slot(array().view_offset + i);
+    if (!array().sparse)
+      return &array().array_elements[i];
+    auto found = array().sparse_slots.find(i);
+    return found == array().sparse_slots.end() ? nullptr : &array().array_elements[found->second];
+  }
+
+  // --- VIEWS ---
+  // a.slice(start, end) shares a's elements instead of copying them: a hands
+  // its storage to a refcounted source and becomes a view of all of it, and
+  // each slice is a view of a range of the same source. Copying a view
+  // copies no elements. The first write to a view copies its range into
+  // storage of its own, or takes the source over when nothing else uses it.
+  // Grids are not shared; slicing one copies the rows.
+  bool is_view() const { return array().view_source != nullptr; }
+
+  void share()
+  {
+    if (is_view() || is_grid())
+      return;
+    size_t length = flat_length();
+    ArrayStorage storage = array().array_storage;
+    auto source = std::make_shared<RuntimeValue>(std::move(*this));
+    *this = TypedArray(storage);
+    array().view_source = std::move(source);
+    array().view_length = length;
+  }
+
+  // Caller checks 0 <= start <= end <= array_length()
+  RuntimeValue slice(size_t start, size_t end)
+  {
+    if (is_grid())
+    {
+      std::vector<RuntimeValue> rows;
+      for (size_t i = start; i < end; i++)
+        rows.push_back(array_get(i));
+      RuntimeValue copy = Array(std::move(rows));
+      copy.try_make_grid();
+      return copy;
+    }
+    share();
+    RuntimeValue view = TypedArray(array().array_storage);
+    view.array().view_source = array().view_source;
+    view.array().view_offset = array().view_offset + start;
+    view.array().view_length = end - start;
+    return view;
+  }
+
+  void unshare()
+  {
+    if (!is_view())
+      return;
+    std::shared_ptr<RuntimeValue> source = std::move(array().view_source);
+    size_t offset = array().view_offset, length = array().view_length;
+    array().view_source = nullptr;
+    array().view_offset = array().view_length = 0;
+    if (source.use_count() == 1 && offset == 0 && length == source->flat_length())
+    {
+      *this = std::move(*source);
+      return;
+    }
+    RuntimeValue copy = TypedArray(source->array().array_storage);
+    if (source->array().sparse)
+    {
+      // Only the written elements in range are copied
+      copy.array().sparse = true;
+      copy.array().sparse_length = length;
+      copy.array().sparse_fill = source->array().sparse_fill;
+      for (auto &entry : source->array().sparse_slots)
+        if (entry.first >= offset && entry.first < offset + length)
+          copy.flat_set(entry.first - offset, source->slot_get(entry.second));
+    }
+    else
+    {
+      copy.slot_resize(length);
+      for (size_t i = 0; i < length; i++)
+        copy.slot_set(i, source->slot_get(offset + i));
+    }
+    *this = std::move(copy);
+  }
+
+  // --- GRIDS ---
+  // A rectangular array of unboxed rows (int[][] with equal-length rows)
+  // stores every cell in one row-major buffer: cell (i, j) lives at flat
+  // index i * grid_columns + j. array_storage then describes the cells.
+  // Anything that would make it jagged turns it back into boxed rows.
+  bool is_grid() const { return array().grid_columns > 0; }
+
+  // Whether 'row' can be stored as a row of this grid as-is
+  bool fits_grid_row(const RuntimeValue &row) const
+  {
+    return row.type == ARRAY && !row.is_grid() && !row.array().sparse && row.array().array_storage == array().array_storage &&
+           row.flat_length() == array().grid_columns;
+  }
+
+  RuntimeValue grid_get(size_t i, size_t j) const { return flat_get(i * array().grid_columns + j); }
+
+  // False (nothing written) when the cell cannot hold v unboxed
+  bool grid_set(size_t i, size_t j, const RuntimeValue &v)
+  {
+    if (!storage_accepts(v))
+      return false;
+    flat_set(i * array().grid_columns + j, v);
+    return true;
+  }
+
+  // Packs boxed rows into a grid when they are unboxed and all one length
+  void try_make_grid()
+  {
+    if (array().array_storage != BOXED || array().sparse || is_view() || array().array_elements.empty())
+      return;
+    const RuntimeValue &first = array().array_elements[0];
+    if (first.type != ARRAY || first.is_grid() || first.array().sparse || first.array().array_storage == BOXED || first.flat_length() == 0)
+      return;
+    RuntimeValue grid = TypedArray(first.array().array_storage);
+    grid.array().grid_columns = first.flat_length();
+    for (auto &row : array().array_elements)
+      if (!grid.fits_grid_row(row))
+        return;
+    grid.array().grid_rows = array().array_elements.size();
+    grid.slot_resize(grid.array().grid_rows * grid.array().grid_columns);
+    for (size_t i = 0; i < grid.array().grid_rows; i++)
+      for (size_t j = 0; j < grid.array().grid_columns; j++)
+        grid.slot_set(i * grid.array().grid_columns + j, array().array_elements[i].flat_get(j));
+    *this = std::move(grid);
+  }
+
+  // Back to a boxed array of separate rows (the jagged fallback)
+  void split_grid()
+  {
+    std::vector<RuntimeValue> rows(array().grid_rows);
+    for (size_t i = 0; i < array().grid_rows; i++)
+      rows[i] = array_get(i);
+    *this = Array(std::move(rows));
+  }
+
+  // --- ARRAY ACCESS (any storage) ---
+  size_t array_length() const { return is_grid() ? array().grid_rows : flat_length(); }
+
+  RuntimeValue array_get(size_t i) const
+  {
+    if (!is_grid())
+      return flat_get(i);
+    RuntimeValue row = TypedArray(array().array_storage);
+    row.flat_resize(array().grid_columns);
+    for (size_t j = 0; j < array().grid_columns; j++)
+      row.flat_set(j, grid_get(i, j));
+    return row;
+  }
+
+  void array_set(size_t i, const RuntimeValue &v)
+  {
+    unshare();
+    if (is_grid())
+    {
+      if (fits_grid_row(v))
+      {
+        for (size_t j = 0; j < array().grid_columns; j++)
+          flat_set(i * array().grid_columns + j, v.flat_get(j));
+        return;
+      }
+      split_grid();
+    }
+    if (!storage_accepts(v))
+      convert_storage(BOXED);
+    flat_set(i, v);
+  }
+
+  void array_resize(size_t n)
+  {
+    unshare();
+    if (is_grid())
+    {
+      if (n == array().grid_rows)
+        return;
+      split_grid(); // new rows start as Void, not as rows of the grid
+    }
+    flat_resize(n);
+  }
+
+  // Grows the array so a write can land at n - 1 (a[i] = v past the end).
+  // It turns sparse instead of filling the gap once n is more than twice
+  // the elements written plus SPARSE_GAP. Counting them is a scan, so it is
+  // only redone after the length has doubled since the last count.
+  void array_expand(size_t n)
+  {
+    unshare();
+    if (is_grid())
+      split_grid();
+    if (!array().sparse && n > slot_count())
+    {
+      size_t &checked = array().dense_checked;
+      if (n > 2 * slot_count() + SPARSE_GAP)
+        make_sparse(n); // too sparse however many slots were written
+      else if (n > 2 * checked + SPARSE_GAP)
+      {
+        if (n > 2 * written_count() + SPARSE_GAP)
+          make_sparse(n);
+        else
+          checked = n;
+      }
+    }
+    flat_resize(n);
+  }
+
+  void array_push(const RuntimeValue &v)
+  {
+    unshare();
+    if (is_grid() && fits_grid_row(v))
+    {
+      flat_resize((array().grid_rows + 1) * array().grid_columns);
+      for (size_t j = 0; j < array().grid_columns; j++)
+        flat_set(array().grid_rows * array().grid_columns + j, v.flat_get(j));
+      array().grid_rows++;
+      return;
+    }
+    array_resize(array_length() + 1);
+    array_set(array_length() - 1, v);
+    // Rows pushed one by one into an empty table start a grid
+    if (array_length() == 1)
+      try_make_grid();
+  }
+
+  // Re-packs the elements into another storage. Moving to a typed storage
+  // only happens when every element fits it.
+  void convert_storage(ArrayStorage target)
+  {
+    if (is_grid())
+    {
+      if (target == BOXED)
+        split_grid();
+      return;
+    }
+    if (target == array().array_storage)
+      return;
+    unshare();
+    size_t n = slot_count();
+    RuntimeValue converted = TypedArray(target);
+    if (array().sparse && target != BOXED && !converted.storage_accepts(hole_value()))
+      return;
+    for (size_t i = 0; i < n; i++)
+      if (!converted.storage_accepts(slot_get(i)))
+        return;
+    converted.slot_resize(n);
+    for (size_t i = 0; i < n; i++)
+      converted.slot_set(i, slot_get(i));
+    if (array().sparse)
+    {
+      // Holes keep reading the same zero
+      converted.array().sparse = true;
+      converted.array().sparse_length = array().sparse_length;
+      converted.array().sparse_slots = std::move(array().sparse_slots);
+      converted.array().sparse_fill = target == BOXED ? array().sparse_fill : target;
+    }
+    *this = std::move(converted);
+  }
 };
 
 class RuntimeObject
@@ -96,13 +731,135 @@ public:
   RuntimeStruct(std::string name) : struct_name(name) {}
 };
 
+// A map<K, V>. Copies of a map value share one RuntimeMap; the first write
+// through a copy that is not the only one clones it (see
+// INTERPRETER::writable_map), so maps behave as values, like arrays.
+// Entries are numbered in insertion order, which is the order keys() and
+// values() list them in, and stored as columns: the keys, their hashes and
+// the values, an array that keeps numbers and bools unboxed the way a V[]
+// does. HASH_INDEX maps a key to its entry number. A removed entry stays
+// behind, dead, until dead ones outnumber the live ones.
+class RuntimeMap
+{
+public:
+  // An int or string key, also used as a step of an assignment target
+  struct KEY
+  {
+    long long number = 0;
+    RUNTIME_STRING text;
+    bool is_text = false;
+
+    size_t hash() const { return is_text ? text.hash() : HASH_INDEX::mix((unsigned long long)number); }
+    bool operator==(const KEY &other) const
+    {
+      return is_text == other.is_text && (is_text ? text == other.text : number == other.number);
+    }
+    RuntimeValue value() const { return is_text ? RuntimeValue::String(text) : RuntimeValue::Integer(number); }
+  };
+
+  std::vector<KEY> keys;
+  std::vector<size_t> hashes;
+  std::vector<bool> live;
+  RuntimeValue values; // array, slot i holds entry i's value
+
+  explicit RuntimeMap(RuntimeValue::ArrayStorage storage) : values(RuntimeValue::TypedArray(storage)) {}
+
+  size_t size() const { return live_count; }
+  size_t entry_count() const { return keys.size(); }
+
+  // Entry number of key, or HASH_INDEX::NONE
+  uint32_t find(const KEY &key) const
+  {
+    size_t hash = key.hash();
+    return index.find(hash, [&](uint32_t e) { return hashes[e] == hash && keys[e] == key; });
+  }
+
+  // Entry number of key, added with V's zero (Void when boxed) if new
+  uint32_t insert(const KEY &key)
+  {
+    size_t hash = key.hash();
+    uint32_t found = index.find(hash, [&](uint32_t e) { return hashes[e] == hash && keys[e] == key; });
+    if (found != HASH_INDEX::NONE)
+      return found;
+    if (!index.insert(hash, (uint32_t)keys.size()))
+    {
+      rebuild();
+      index.insert(hash, (uint32_t)keys.size());
+    }
+    keys.push_back(key);
+    hashes.push_back(hash);
+    live.push_back(true);
+    values.flat_resize(keys.size());
+    live_count++;
+    return (uint32_t)keys.size() - 1;
+  }
+
+  // False if there was no such key
+  bool remove(const KEY &key)
+  {
+    size_t hash = key.hash();
+    uint32_t found = index.erase(hash, [&](uint32_t e) { return hashes[e] == hash && keys[e] == key; });
+    if (found == HASH_INDEX::NONE)
+      return false;
+    keys[found] = KEY();
+    live[found] = false;
+    if (values.array().array_storage == RuntimeValue::BOXED)
+      values.array().array_elements[found] = RuntimeValue::Void();
+    live_count--;
+    if (keys.size() - live_count > live_count)
+      rebuild();
+    return true;
+  }
+
+private:
+  HASH_INDEX index;
+  size_t live_count = 0;
+
+  // Drops the dead entries and re-files the rest in an index with room
+  // to double
+  void rebuild()
+  {
+    size_t kept = 0;
+    for (size_t i = 0; i < keys.size(); i++)
+      if (live[i])
+      {
+        if (kept != i)
+        {
+          keys[kept] = std::move(keys[i]);
+          hashes[kept] = hashes[i];
+          if (values.array().array_storage == RuntimeValue::BOXED)
+            values.array().array_elements[kept] = std::move(values.array().array_elements[i]);
+          else
+            values.slot_set(kept, values.slot_get(i));
+        }
+        kept++;
+      }
+    keys.resize(kept);
+    hashes.resize(kept);
+    live.assign(kept, true);
+    values.flat_resize(kept);
+    index.reset(2 * kept);
+    for (size_t i = 0; i < kept; i++)
+      index.insert(hashes[i], (uint32_t)i);
+  }
+};
+
+// Empty; the values are kept in 'storage' (see storage_for)
+inline RuntimeValue RuntimeValue::Map(ArrayStorage storage)
+{
+  RuntimeValue r;
+  r.type = MAP;
+  r.map_val = std::make_shared<RuntimeMap>(storage);
+  return r;
+}
+
 inline RuntimeValue RuntimeValue::copy_value(RuntimeValue val)
 {
   if (val.type == STRUCT && val.struct_val != nullptr)
   {
     auto cloned_struct = std::make_shared<RuntimeStruct>(val.struct_val->struct_name);
     cloned_struct->fields = val.struct_val->fields;
-    RuntimeValue new_val = val;
+    RuntimeValue new_val = std::move(val);
     new_val.struct_val = cloned_struct;
     return new_val;
   }
@@ -127,73 +884,52 @@ class ENVIRONMENT
 public:
   ENVIRONMENT *parent = nullptr;
   std::unordered_map<std::string, RuntimeValue> variables;
+  RuntimeValue *this_slot = nullptr; // variables["this"] once defined
   ENVIRONMENT(ENVIRONMENT *p = nullptr) : parent(p) {}
-  void define(std::string name, RuntimeValue val) { variables[name] = RuntimeValue::copy_value(val); }
-  void assign(std::string name, RuntimeValue val)
+  void define(const std::string &name, RuntimeValue val)
   {
-    if (variables.count(name))
-    {
-      variables[name] = RuntimeValue::copy_value(val);
-      return;
-    }
+    RuntimeValue &slot = variables[name];
+    slot = RuntimeValue::copy_value(std::move(val));
+    if (name == "this")
+      this_slot = &slot;
+  }
+  void assign(const std::string &name, RuntimeValue val) { *lookup(name) = RuntimeValue::copy_value(std::move(val)); }
+  const RuntimeValue &get(const std::string &name) { return *lookup(name); }
+
+  // Storage slot for a name: local variables first, then fields of the
+  // enclosing 'this', then the parent scope.
+  RuntimeValue *lookup(const std::string &name)
+  {
+    auto found = variables.find(name);
+    if (found != variables.end())
+      return &found->second;
     ENVIRONMENT *curr = this;
     while (curr)
     {
-      if (curr->variables.count("this"))
+      if (curr->this_slot)
       {
-        auto &this_val = curr->variables["this"];
+        auto &this_val = *curr->this_slot;
         if (this_val.type == RuntimeValue::OBJECT && this_val.object_val != nullptr)
         {
-          if (this_val.object_val->fields.count(name))
-          {
-            this_val.object_val->fields[name] = RuntimeValue::copy_value(val);
-            return;
-          }
+          auto field = this_val.object_val->fields.find(name);
+          if (field != this_val.object_val->fields.end())
+            return &field->second;
         }
         break;
       }
       curr = curr->parent;
     }
     if (parent)
-    {
-      parent->assign(name, val);
-      return;
-    }
+      return parent->lookup(name);
     std::cerr << "Runtime Error: Undefined variable '" << name << "'." << std::endl;
     exit(1);
   }
-  RuntimeValue get(std::string name)
-  {
-    if (variables.count(name))
-      return variables[name];
-    ENVIRONMENT *curr = this;
-    while (curr)
-    {
-      if (curr->variables.count("this"))
-      {
-        auto &this_val = curr->variables["this"];
-        if (this_val.type == RuntimeValue::OBJECT && this_val.object_val != nullptr)
-        {
-          if (this_val.object_val->fields.count(name))
-          {
-            return this_val.object_val->fields[name];
-          }
-        }
-        break;
-      }
-      curr = curr->parent;
-    }
-    if (parent)
-      return parent->get(name);
-    std::cerr << "Runtime Error: Undefined variable '" << name << "'." << std::endl;
-    exit(1);
-  }
-};
-
-class INTERPRETER : public AST_VISITOR
-{
-private:
-  struct ClassDefinition
+};
+
+class INTERPRETER : public AST_VISITOR
+{
+private:
+  struct ClassDefinition
   {
     std::string name;
     std::string superclass;
@@ -215,55 +951,453 @@ private:
   std::unordered_map<std::string, ClassDefinition> classes;
   std::unordered_map<std::string, StructDefinition> structs;
 
-  void update_value_in_environment(EXPRESSION *expr, RuntimeValue updated_val)
+  // Where print writes: std::cout, or the buffer of the parallel loop chunk
+  // being run
+  std::ostream *output = &std::cout;
+
+  // Parallel loops (see run_parallel_loop). A worker runs chunks for one
+  // pool thread; parallel_written lists the arrays it shares with the other
+  // workers for writing.
+  bool in_parallel_worker = false;
+  std::vector<const RuntimeValue *> parallel_written;
+  std::vector<std::unique_ptr<INTERPRETER>> parallel_workers; // kept from one loop to the next
+
+  // input() and read_line() share stdin; files are opened on first read
+  LINE_READER stdin_reader{0, false};
+  std::unordered_map<std::string, std::unique_ptr<LINE_READER>> file_readers;
+
+  LINE_READER &reader_for(CALL_EXPRESSION *expr)
+  {
+    if (expr->arguments.empty())
+      return stdin_reader;
+    expr->arguments[0]->accept(this);
+    std::string path = last_evaluated_value.string_val.str();
+    auto &reader = file_readers[path];
+    if (!reader)
+      reader.reset(LINE_READER::open_file(path));
+    if (!reader)
+    {
+      std::cerr << "Runtime Error: Could not open file '" << path << "'." << std::endl;
+      exit(1);
+    }
+    return *reader;
+  }
+
+  // Whole remaining input for the bulk loaders: stdin, or a fresh read of
+  // the file so each column call sees every row
+  std::string read_all_input(CALL_EXPRESSION *expr)
+  {
+    std::string text;
+    if (expr->arguments.empty())
+    {
+      stdin_reader.read_rest(text);
+      return text;
+    }
+    expr->arguments[0]->accept(this);
+    std::string path = last_evaluated_value.string_val.str();
+    std::unique_ptr<LINE_READER> reader(LINE_READER::open_file(path));
+    if (!reader)
+    {
+      std::cerr << "Runtime Error: Could not open file '" << path << "'." << std::endl;
+      exit(1);
+    }
+    reader->read_rest(text);
+    return text;
+  }
+
+  // read_ints / read_floats / read_int_column / read_float_column
+  template <typename T>
+  RuntimeValue load_numbers(CALL_EXPRESSION *expr, const std::string &name)
   {
-      if (auto varExpr = dynamic_cast<VARIABLE_EXPRESSION *>(expr))
+    std::string text = read_all_input(expr);
+    std::vector<T> numbers;
+    NUMERIC_LOADER::PARSE_ERROR error;
+    bool ok;
+    if (expr->arguments.size() < 2)
+      ok = NUMERIC_LOADER::parse_all(text, numbers, error);
+    else
+    {
+      expr->arguments[1]->accept(this);
+      long long column = last_evaluated_value.int_val;
+      bool by_name = last_evaluated_value.type == RuntimeValue::STRING;
+      if (by_name)
       {
-          current_environment->assign(varExpr->name.VALUE, updated_val);
+        column = NUMERIC_LOADER::find_column(text, last_evaluated_value.string_val.str());
+        if (column < 0)
+        {
+          std::cerr << "Runtime Error: " << name << "(): no column named '" << last_evaluated_value.string_val << "'." << std::endl;
+          exit(1);
+        }
       }
-      else if (auto getExpr = dynamic_cast<GET_EXPRESSION *>(expr))
+      // Judged by the first row; an empty input has no rows to be short
+      size_t columns = NUMERIC_LOADER::count_columns(text);
+      if (column < 0 || (columns > 0 && (unsigned long long)column >= columns))
       {
-          getExpr->object_expression->accept(this);
-          RuntimeValue obj_val = last_evaluated_value;
+        std::cerr << "Runtime Error: " << name << "(): column " << column << " is out of range; the rows have " << columns
+                  << " columns." << std::endl;
+        exit(1);
+      }
+      ok = NUMERIC_LOADER::parse_column(text, (size_t)column, by_name, numbers, error);
+    }
+    if (!ok)
+    {
+      std::cerr << "Runtime Error: " << name << "(): '" << error.token << "' is not a number (line " << error.line << ")." << std::endl;
+      exit(1);
+    }
 
-          if (obj_val.type == RuntimeValue::OBJECT && obj_val.object_val)
-          {
-              obj_val.object_val->fields[getExpr->member_name.VALUE] = updated_val;
-          }
-          else if (obj_val.type == RuntimeValue::STRUCT && obj_val.struct_val)
-          {
-              obj_val.struct_val->fields[getExpr->member_name.VALUE] = updated_val;
-          }
-          else
-          {
-              std::cerr << "Runtime Error: Cannot assign property on non-object type." << std::endl;
-              exit(1);
-          }
+    // Parsed numbers become the array's unboxed storage as-is
+    if constexpr (std::is_same<T, long long>::value)
+    {
+      RuntimeValue array = RuntimeValue::TypedArray(RuntimeValue::INT_ELEMENTS);
+      array.array().int_elements = std::move(numbers);
+      return array;
+    }
+    else
+    {
+      RuntimeValue array = RuntimeValue::TypedArray(RuntimeValue::FLOAT_ELEMENTS);
+      array.array().float_elements = std::move(numbers);
+      return array;
+    }
+  }
+
+  // A resolved assignment target: a stable storage slot (variable or field)
+  // plus the array indices and map keys leading from it to the element. The
+  // path is walked again after evaluating a right-hand side, since that
+  // evaluation may reallocate the arrays and maps along it.
+  struct LOCATION
+  {
+    RuntimeValue *slot = nullptr;
+    std::vector<RuntimeMap::KEY> keys; // an array index is an int key
+    std::shared_ptr<RuntimeObject> object_owner; // keeps a field slot alive
+    std::shared_ptr<RuntimeStruct> struct_owner;
+  };
+
+  // Whether resolve_location accepts the expression: a variable, a member,
+  // or an element of one of those
+  static bool is_assignable(EXPRESSION *expr)
+  {
+    if (expr->kind == NODE_ARRAY_ACCESS_EXPRESSION)
+      return is_assignable(static_cast<ARRAY_ACCESS_EXPRESSION *>(expr)->array_expression);
+    return expr->kind == NODE_VARIABLE_EXPRESSION || expr->kind == NODE_GET_EXPRESSION;
+  }
+
+  // Evaluates the sub-expressions of a target (object, indices) exactly once
+  LOCATION resolve_location(EXPRESSION *target)
+  {
+    switch (target->kind)
+    {
+    case NODE_VARIABLE_EXPRESSION:
+    {
+      LOCATION loc;
+      loc.slot = current_environment->lookup(static_cast<VARIABLE_EXPRESSION *>(target)->name.VALUE);
+      return loc;
+    }
+    case NODE_GET_EXPRESSION:
+    {
+      auto get_expr = static_cast<GET_EXPRESSION *>(target);
+      get_expr->object_expression->accept(this);
+      RuntimeValue obj_val = last_evaluated_value;
+      std::string member = get_expr->member_name.VALUE;
+
+      LOCATION loc;
+      if (obj_val.type == RuntimeValue::OBJECT && obj_val.object_val != nullptr)
+      {
+        auto field = obj_val.object_val->fields.find(member);
+        if (field == obj_val.object_val->fields.end())
+        {
+          std::cerr << "Runtime Error: Field '" << member << "' not found on object of class '" << obj_val.object_val->class_name << "'." << std::endl;
+          exit(1);
+        }
+        loc.slot = &field->second;
+        loc.object_owner = obj_val.object_val;
       }
-      else if (auto arrAcc = dynamic_cast<ARRAY_ACCESS_EXPRESSION *>(expr))
+      else if (obj_val.type == RuntimeValue::STRUCT && obj_val.struct_val != nullptr)
       {
-          arrAcc->array_expression->accept(this);
-          RuntimeValue parent_arr = last_evaluated_value;
-          
-          arrAcc->index_expression->accept(this);
-          RuntimeValue idx = last_evaluated_value;
-          
-          if (idx.int_val < 0) {
-              std::cerr << "Runtime Error: Array index cannot be negative." << std::endl;
-              exit(1);
-          }
-          if (idx.int_val >= parent_arr.array_elements.size()) {
-              parent_arr.array_elements.resize(idx.int_val + 1, RuntimeValue::Void());
-          }
-          parent_arr.array_elements[idx.int_val] = updated_val;
-          
-          update_value_in_environment(arrAcc->array_expression, parent_arr);
+        auto field = obj_val.struct_val->fields.find(member);
+        if (field == obj_val.struct_val->fields.end())
+        {
+          std::cerr << "Runtime Error: Field '" << member << "' not found on struct '" << obj_val.struct_val->struct_name << "'." << std::endl;
+          exit(1);
+        }
+        loc.slot = &field->second;
+        loc.struct_owner = obj_val.struct_val;
       }
       else
       {
-          std::cerr << "Runtime Error: Invalid assignment target." << std::endl;
+        std::cerr << "Runtime Error: Cannot set member of non-object/non-struct." << std::endl;
+        exit(1);
+      }
+      return loc;
+    }
+    case NODE_ARRAY_ACCESS_EXPRESSION:
+    {
+      auto access = static_cast<ARRAY_ACCESS_EXPRESSION *>(target);
+      LOCATION loc = resolve_location(access->array_expression);
+      access->index_expression->accept(this);
+      loc.keys.push_back(location_key(last_evaluated_value));
+      return loc;
+    }
+    default:
+      std::cerr << "Runtime Error: Invalid assignment target." << std::endl;
+      exit(1);
+    }
+  }
+
+  // An index or map key as a step of a location
+  RuntimeMap::KEY location_key(const RuntimeValue &index)
+  {
+    RuntimeMap::KEY key;
+    if (index.type == RuntimeValue::STRING)
+    {
+      key.text = index.string_val;
+      key.is_text = true;
+    }
+    else if (index.type == RuntimeValue::INT)
+      key.number = index.int_val;
+    else
+    {
+      std::cerr << "Index not int." << std::endl;
+      exit(1);
+    }
+    return key;
+  }
+
+  // Key of a map<K, V> lookup: an int or a string
+  RuntimeMap::KEY evaluate_key(EXPRESSION *key_expression)
+  {
+    key_expression->accept(this);
+    return location_key(last_evaluated_value);
+  }
+
+  // The array index a location step stands for
+  long long array_index(const RuntimeMap::KEY &key)
+  {
+    if (key.is_text)
+    {
+      std::cerr << "Index not int." << std::endl;
+      exit(1);
+    }
+    return key.number;
+  }
+
+  // The map a write goes to, cloned first if another value shares it
+  RuntimeMap &writable_map(RuntimeValue &map)
+  {
+    if (map.map_val.use_count() > 1)
+      map.map_val = std::make_shared<RuntimeMap>(*map.map_val);
+    return *map.map_val;
+  }
+
+  void missing_key(const RuntimeMap::KEY &key)
+  {
+    std::cerr << "Runtime Error: Key '";
+    if (key.is_text)
+      std::cerr << key.text;
+    else
+      std::cerr << key.number;
+    std::cerr << "' not found in map." << std::endl;
+    exit(1);
+  }
+
+  // Entry number of key, which must be there
+  uint32_t map_entry(const RuntimeValue &map, const RuntimeMap::KEY &key)
+  {
+    uint32_t entry = map.map_val->find(key);
+    if (entry == HASH_INDEX::NONE)
+      missing_key(key);
+    return entry;
+  }
+
+  RuntimeValue map_get(const RuntimeValue &map, const RuntimeMap::KEY &key)
+  {
+    return map.map_val->values.array_get(map_entry(map, key));
+  }
+
+  // A boxed value (an array or map) under key, in place; nullptr when the
+  // map keeps its values unboxed
+  const RuntimeValue *map_element(const RuntimeValue &map, const RuntimeMap::KEY &key)
+  {
+    uint32_t entry = map_entry(map, key);
+    const RuntimeValue &values = map.map_val->values;
+    return values.array().array_storage == RuntimeValue::BOXED ? values.element_slot(entry) : nullptr;
+  }
+
+  // Errors unless 'array' is an array with an element at idx
+  void check_element(const RuntimeValue &array, long long idx)
+  {
+    if (array.type != RuntimeValue::ARRAY)
+    {
+      std::cerr << "Not an array." << std::endl;
+      exit(1);
+    }
+    if (idx < 0 || idx >= (long long)array.array_length())
+    {
+      std::cerr << "Index out of bounds." << std::endl;
+      exit(1);
+    }
+  }
+
+  // Errors unless (i, j) is a cell of 'grid'
+  void check_cell(const RuntimeValue &grid, long long i, long long j)
+  {
+    if (i < 0 || j < 0 || i >= (long long)grid.array().grid_rows || j >= (long long)grid.array().grid_columns)
+    {
+      std::cerr << "Index out of bounds." << std::endl;
+      exit(1);
+    }
+  }
+
+  // Storage reached by following the first 'depth' steps of a location.
+  // Only boxed arrays hold elements that are themselves arrays, so a grid
+  // on the way is split back into rows. A map on the way must have the key.
+  RuntimeValue *walk_location(LOCATION &loc, size_t depth)
+  {
+    RuntimeValue *current = loc.slot;
+    for (size_t i = 0; i < depth; i++)
+    {
+      if (current->type == RuntimeValue::MAP)
+      {
+        uint32_t entry = map_entry(*current, loc.keys[i]);
+        RuntimeValue &values = writable_map(*current).values;
+        if (values.array().array_storage != RuntimeValue::BOXED)
+        {
+          std::cerr << "Not an array." << std::endl;
           exit(1);
+        }
+        current = values.element_slot(entry);
+        continue;
+      }
+      long long idx = array_index(loc.keys[i]);
+      check_element(*current, idx);
+      if (current->is_grid())
+        current->split_grid();
+      if (current->array().array_storage != RuntimeValue::BOXED)
+      {
+        std::cerr << "Not an array." << std::endl;
+        exit(1);
+      }
+      RuntimeValue *element = current->element_slot(idx);
+      if (!element)
+      {
+        // Hole of a sparse array: never an array
+        std::cerr << "Not an array." << std::endl;
+        exit(1);
       }
+      current = element;
+    }
+    return current;
+  }
+
+  // Grid addressed by all but the last two steps, if there is one
+  RuntimeValue *location_grid(LOCATION &loc)
+  {
+    size_t n = loc.keys.size();
+    if (n < 2 || loc.keys[n - 2].is_text || loc.keys[n - 1].is_text)
+      return nullptr;
+    RuntimeValue *grid = walk_location(loc, n - 2);
+    return grid->is_grid() ? grid : nullptr;
+  }
+
+  // Current value of a location; array elements and map keys must
+  // already exist
+  RuntimeValue read_location(LOCATION &loc)
+  {
+    if (loc.keys.empty())
+      return *loc.slot;
+    size_t n = loc.keys.size();
+    if (RuntimeValue *grid = location_grid(loc))
+    {
+      check_cell(*grid, loc.keys[n - 2].number, loc.keys[n - 1].number);
+      return grid->grid_get(loc.keys[n - 2].number, loc.keys[n - 1].number);
+    }
+    RuntimeValue *array = walk_location(loc, n - 1);
+    if (array->type == RuntimeValue::MAP)
+      return map_get(*array, loc.keys.back());
+    long long idx = array_index(loc.keys.back());
+    check_element(*array, idx);
+    return array->array_get(idx);
+  }
+
+  // Stores into a location. With 'expand' the last index may lie past the
+  // end of its array, which grows to fit (a[i] = v), and a map gains the
+  // last key if it is new; negative array indices are rejected.
+  void write_location(LOCATION &loc, const RuntimeValue &value, bool expand = false)
+  {
+    if (loc.keys.empty())
+    {
+      *loc.slot = RuntimeValue::copy_value(value);
+      return;
+    }
+    size_t n = loc.keys.size();
+    long long idx = loc.keys.back().number;
+
+    // A grid cell is written at its offset, unless the write would make the
+    // grid jagged or needs boxing; walk_location then splits it
+    if (RuntimeValue *grid = location_grid(loc))
+    {
+      long long row = loc.keys[n - 2].number;
+      if (row >= 0 && row < (long long)grid->array().grid_rows && idx >= 0 && idx < (long long)grid->array().grid_columns &&
+          grid->grid_set(row, idx, value))
+        return;
+    }
+
+    RuntimeValue *array = walk_location(loc, n - 1);
+    if (array->type == RuntimeValue::MAP)
+    {
+      RuntimeMap &map = writable_map(*array);
+      uint32_t entry = expand ? map.insert(loc.keys.back()) : map_entry(*array, loc.keys.back());
+      map.values.array_set(entry, RuntimeValue::copy_value(value));
+      return;
+    }
+    idx = array_index(loc.keys.back());
+    if (expand && idx < 0)
+    {
+      std::cerr << "Runtime Error: Array index cannot be negative." << std::endl;
+      exit(1);
+    }
+    if (array->type != RuntimeValue::ARRAY)
+    {
+      std::cerr << "Not an array." << std::endl;
+      exit(1);
+    }
+    if (expand && idx >= (long long)array->array_length())
+      array->array_expand(idx + 1);
+    check_element(*array, idx);
+    check_parallel_store(array, value);
+    array->array_set(idx, RuntimeValue::copy_value(value));
+  }
+
+  // A parallel loop worker stores into the loop's shared arrays in place
+  // only: re-packing one (a float into int storage, say) would move the
+  // elements the other threads are writing
+  void check_parallel_store(const RuntimeValue *array, const RuntimeValue &value)
+  {
+    if (parallel_written.empty() || array->storage_accepts(value) ||
+        std::find(parallel_written.begin(), parallel_written.end(), array) == parallel_written.end())
+      return;
+    std::cerr << "Runtime Error: Parallel loop stores a value its shared array cannot hold unconverted; convert it first." << std::endl;
+    exit(1);
+  }
+
+  static bool is_map_type(const std::string &type) { return type.compare(0, 4, "map<") == 0 && type.back() == '>'; }
+
+  // An empty map of a declared "map<K,V>", keeping V's values unboxed
+  // when V is a number or bool
+  static RuntimeValue empty_map(const std::string &type)
+  {
+    int depth = 0;
+    size_t comma = 4;
+    for (; comma < type.size(); comma++)
+    {
+      if (type[comma] == '<')
+        depth++;
+      else if (type[comma] == '>')
+        depth--;
+      else if (type[comma] == ',' && depth == 0)
+        break;
+    }
+    std::string value_type = type.substr(comma + 1, type.size() - comma - 2);
+    return RuntimeValue::Map(RuntimeValue::storage_for(value_type));
   }
 
   bool is_truthy(RuntimeValue v)
@@ -275,6 +1409,14 @@ private:
     return false;
   }
 
+  // A worker for run_parallel_loop, on the parent's globals
+  explicit INTERPRETER(const INTERPRETER *parent)
+  {
+    global_environment = parent->global_environment;
+    current_environment = global_environment;
+    in_parallel_worker = true;
+  }
+
 public:
   INTERPRETER()
   {
@@ -300,6 +1442,21 @@ public:
     catch (const ContinueException &)
     {
     }
+    catch (const std::bad_alloc &)
+    {
+      out_of_memory();
+    }
+    catch (const std::length_error &)
+    {
+      out_of_memory();
+    }
+  }
+
+  // An allocation too big for the machine is a runtime error, not an abort
+  static void out_of_memory()
+  {
+    std::cerr << "Runtime Error: Out of memory." << std::endl;
+    exit(1);
   }
 
   void visit(LITERAL_EXPRESSION *expr) override
@@ -313,10 +1470,8 @@ public:
       last_evaluated_value = RuntimeValue::Float(std::stod(expr->token.VALUE));
       break;
     case TOKEN_STRING_LITERAL:
-      last_evaluated_value = RuntimeValue::String(expr->token.VALUE);
-      break;
     case TOKEN_CHAR_LITERAL:
-      last_evaluated_value = RuntimeValue::String(expr->token.VALUE);
+      last_evaluated_value = RuntimeValue::String(expr->text); // interned by the node
       break;
     case TOKEN_TRUE:
       last_evaluated_value = RuntimeValue::Bool(true);
@@ -332,7 +1487,19 @@ public:
     }
   }
 
-  void visit(VARIABLE_EXPRESSION *expr) override { last_evaluated_value = current_environment->get(expr->name.VALUE); }
+  // Copy of a stored value that shares the slot's array (see VIEWS) instead
+  // of duplicating its elements; the slot copies them back on its next write
+  // only if the copy is still alive by then. A parallel loop worker leaves
+  // the slot alone, as other threads may be reading it, and copies the
+  // elements unless the slot is a view already.
+  RuntimeValue shared_copy(RuntimeValue &slot)
+  {
+    if (slot.type == RuntimeValue::ARRAY && !in_parallel_worker)
+      slot.share();
+    return slot;
+  }
+
+  void visit(VARIABLE_EXPRESSION *expr) override { last_evaluated_value = shared_copy(*current_environment->lookup(expr->name.VALUE)); }
 
   void visit(VARIABLE_DECLARATION_STATEMENT *stmt) override
   {
@@ -340,354 +1507,2047 @@ public:
     if (stmt->initializer_expression)
     {
       stmt->initializer_expression->accept(this);
-      val = last_evaluated_value;
+      val = std::move(last_evaluated_value);
     }
-    current_environment->define(stmt->name_token.VALUE, val);
+
+    // T[] with a primitive T: start (or re-pack, e.g. from []) unboxed
+    const std::string &type = stmt->type_token.VALUE;
+    if (type.size() > 2 && type.compare(type.size() - 2, 2, "[]") == 0)
+    {
+      RuntimeValue::ArrayStorage storage = RuntimeValue::storage_for(type.substr(0, type.size() - 2));
+      if (!stmt->initializer_expression)
+        val = RuntimeValue::TypedArray(storage);
+      else if (val.type == RuntimeValue::ARRAY && val.array().array_storage == RuntimeValue::BOXED)
+        val.convert_storage(storage);
+    }
+    else if (!stmt->initializer_expression && is_map_type(type))
+      val = empty_map(type); // map<K, V> m; starts empty
+    current_environment->define(stmt->name_token.VALUE, std::move(val));
   }
 
-  void visit(ASSIGNMENT_EXPRESSION *expr) override
+  // Appends the text of 'pieces' to a string variable's own buffer
+  // (std::string grows geometrically, so each append is amortized O(1))
+  void append_in_place(RuntimeValue &target, const std::vector<RuntimeValue> &pieces)
   {
-    expr->value_expression->accept(this);
-    current_environment->assign(expr->variable_name.VALUE, last_evaluated_value);
+    char buffer[NUMBER_FORMATTER::BUFFER_SIZE];
+    for (auto &piece : pieces)
+      target.string_val.append(concat_text(piece, buffer));
+    last_evaluated_value = RuntimeValue::Void(); // statement level, value unused
   }
 
-  // FINAL VERSION: Supports Int, Float, Bool, Byte, Short, Long, Double
-  void visit(BINARY_EXPRESSION *expr) override
+  void visit(ASSIGNMENT_EXPRESSION *expr) override
   {
-    expr->left_operand->accept(this);
-    RuntimeValue left = last_evaluated_value;
-    expr->right_operand->accept(this);
-    RuntimeValue right = last_evaluated_value;
-
-    // 1. BOOLEAN COMPARISON FIX (Handle == and != for booleans)
-    if (left.type == RuntimeValue::BOOL && right.type == RuntimeValue::BOOL)
+    // s = s + a + b: evaluate a and b, then append them to s
+    if (expr->appends_to_target)
     {
-      if (expr->operator_token.TYPE == TOKEN_DOUBLE_EQUALS)
-      {
-        last_evaluated_value = RuntimeValue::Bool(left.bool_val == right.bool_val);
-        return;
-      }
-      if (expr->operator_token.TYPE == TOKEN_NOT_EQUALS)
+      RuntimeValue *target = current_environment->lookup(expr->variable_name.VALUE);
+      if (target->type == RuntimeValue::STRING)
       {
-        last_evaluated_value = RuntimeValue::Bool(left.bool_val != right.bool_val);
+        auto &parts = static_cast<CONCAT_EXPRESSION *>(expr->value_expression)->parts;
+        std::vector<RuntimeValue> pieces;
+        pieces.reserve(parts.size() - 1);
+        for (size_t i = 1; i < parts.size(); i++)
+        {
+          parts[i]->accept(this);
+          pieces.push_back(std::move(last_evaluated_value));
+        }
+        append_in_place(*target, pieces);
         return;
       }
-      // Booleans don't support >, <, +, etc.
-      return;
     }
+    expr->value_expression->accept(this);
+    RuntimeValue *slot = current_environment->lookup(expr->variable_name.VALUE);
+    *slot = RuntimeValue::copy_value(std::move(last_evaluated_value));
+    last_evaluated_value = shared_copy(*slot);
+  }
 
-    // 2. STRING CONCATENATION
-    if (expr->operator_token.TYPE == TOKEN_PLUS)
+  // --- ELEMENT-WISE ARRAYS ---
+  // One operand of a whole-array operator or reduction as a flat buffer of
+  // ints or doubles. Unboxed int/float arrays and views are read in place;
+  // anything else (byte or boxed elements, sparse storage, a number to
+  // broadcast) is copied out first.
+  struct NUMERIC_SPAN
+  {
+    bool is_float = false;
+    const long long *ints = nullptr;
+    const double *floats = nullptr;
+    size_t length = 0;
+    std::vector<long long> int_copy;
+    std::vector<double> float_copy;
+
+    const double *as_floats()
     {
-      if (left.type == RuntimeValue::STRING || right.type == RuntimeValue::STRING)
+      if (!is_float)
       {
-        std::string l_str = (left.type == RuntimeValue::STRING) ? left.string_val : (left.type == RuntimeValue::INT ? std::to_string(left.int_val) : (left.type == RuntimeValue::BOOL ? (left.bool_val ? "true" : "false") : std::to_string(left.float_val)));
-        std::string r_str = (right.type == RuntimeValue::STRING) ? right.string_val : (right.type == RuntimeValue::INT ? std::to_string(right.int_val) : (right.type == RuntimeValue::BOOL ? (right.bool_val ? "true" : "false") : std::to_string(right.float_val)));
-        last_evaluated_value = RuntimeValue::String(l_str + r_str);
-        return;
+        float_copy.resize(length);
+        VECTOR_KERNELS::widen(ints, float_copy.data(), length);
+        floats = float_copy.data();
+        is_float = true;
       }
+      return floats;
     }
+  };
 
-    // 3. NUMERIC MATH (Handles Byte, Short, Int, Long, Float, Double)
-    // We promote everything to 'double' for calculation if one side is float/double
-    // We promote everything to 'long long' if both sides are integers
-
-    double l_val = (left.type == RuntimeValue::INT) ? (double)left.int_val : left.float_val;
-    double r_val = (right.type == RuntimeValue::INT) ? (double)right.int_val : right.float_val;
-    bool are_ints = (left.type == RuntimeValue::INT && right.type == RuntimeValue::INT);
+  static bool is_number(const RuntimeValue &v) { return v.type == RuntimeValue::INT || v.type == RuntimeValue::FLOAT; }
 
-    switch (expr->operator_token.TYPE)
-    {
-    case TOKEN_PLUS:
-      if (are_ints)
-        last_evaluated_value = RuntimeValue::Integer(left.int_val + right.int_val);
-      else
-        last_evaluated_value = RuntimeValue::Float(l_val + r_val);
-      break;
+  // A sparse array, or a view of one
+  static bool is_sparse(const RuntimeValue &v)
+  {
+    return v.type == RuntimeValue::ARRAY && (v.is_view() ? v.array().view_source->array().sparse : v.array().sparse);
+  }
 
-    case TOKEN_MINUS:
-      if (are_ints)
-        last_evaluated_value = RuntimeValue::Integer(left.int_val - right.int_val);
-      else
-        last_evaluated_value = RuntimeValue::Float(l_val - r_val);
-      break;
+  // An array whose elements are stored, or whose holes read, as floats
+  static bool has_float_storage(const RuntimeValue &v)
+  {
+    if (v.type != RuntimeValue::ARRAY)
+      return false;
+    const RuntimeValue &storage = v.is_view() ? *v.array().view_source : v;
+    return storage.array().array_storage == RuntimeValue::FLOAT_ELEMENTS || (storage.array().sparse && storage.array().sparse_fill == RuntimeValue::FLOAT_ELEMENTS);
+  }
 
-    case TOKEN_ASTERISK:
-      if (are_ints)
-        last_evaluated_value = RuntimeValue::Integer(left.int_val * right.int_val);
+  // An array as a span, or a number repeated 'length' times
+  static void numeric_span(const RuntimeValue &v, size_t length, NUMERIC_SPAN &span)
+  {
+    if (v.type != RuntimeValue::ARRAY)
+    {
+      span.length = length;
+      span.is_float = v.type == RuntimeValue::FLOAT;
+      if (span.is_float)
+        span.float_copy.assign(length, v.float_val);
       else
-        last_evaluated_value = RuntimeValue::Float(l_val * r_val);
-      break;
-
-    case TOKEN_SLASH:
-      if (r_val == 0)
+        span.int_copy.assign(length, v.int_val);
+    }
+    else
+    {
+      size_t offset;
+      const RuntimeValue *storage = numeric_elements(v, offset);
+      span.length = v.flat_length();
+      if (storage)
       {
-        std::cerr << "Runtime Error: Division by zero." << std::endl;
-        exit(1);
+        span.is_float = storage->array().array_storage == RuntimeValue::FLOAT_ELEMENTS;
+        if (span.is_float)
+          span.floats = storage->array().float_elements.data() + offset;
+        else
+          span.ints = storage->array().int_elements.data() + offset;
+        return;
       }
-      if (are_ints)
-        last_evaluated_value = RuntimeValue::Integer(left.int_val / right.int_val);
-      else
-        last_evaluated_value = RuntimeValue::Float(l_val / r_val);
-      break;
-
-    case TOKEN_PERCENT:
-      if (are_ints)
-        last_evaluated_value = RuntimeValue::Integer(left.int_val % right.int_val);
-      else
+      std::vector<RuntimeValue> elements;
+      for (size_t k = 0; k < span.length && !v.is_grid(); k++)
+      {
+        elements.push_back(v.flat_get(k));
+        if (!is_number(elements.back()))
+          break;
+        span.is_float = span.is_float || elements.back().type == RuntimeValue::FLOAT;
+      }
+      if (v.is_grid() || elements.size() != span.length || (!elements.empty() && !is_number(elements.back())))
       {
-        std::cerr << "Runtime Error: Modulo on floats not supported." << std::endl;
+        std::cerr << "Runtime Error: Array operations need arrays of numbers." << std::endl;
         exit(1);
       }
-      break;
+      for (auto &element : elements)
+      {
+        if (span.is_float)
+          span.float_copy.push_back(element.type == RuntimeValue::FLOAT ? element.float_val : (double)element.int_val);
+        else
+          span.int_copy.push_back(element.int_val);
+      }
+    }
+    span.ints = span.int_copy.data();
+    span.floats = span.float_copy.data();
+  }
 
-    case TOKEN_GREATER_THAN:
-      last_evaluated_value = RuntimeValue::Bool(l_val > r_val);
-      break;
-    case TOKEN_LESS_THAN:
-      last_evaluated_value = RuntimeValue::Bool(l_val < r_val);
-      break;
-    case TOKEN_GREATER_EQUAL:
-      last_evaluated_value = RuntimeValue::Bool(l_val >= r_val);
-      break;
-    case TOKEN_LESS_EQUAL:
-      last_evaluated_value = RuntimeValue::Bool(l_val <= r_val);
-      break;
-    case TOKEN_DOUBLE_EQUALS:
-      last_evaluated_value = RuntimeValue::Bool(l_val == r_val);
-      break;
-    case TOKEN_NOT_EQUALS:
-      last_evaluated_value = RuntimeValue::Bool(l_val != r_val);
-      break;
-    default:
-      break;
+  static RuntimeValue int_array(std::vector<long long> elements)
+  {
+    RuntimeValue r = RuntimeValue::TypedArray(RuntimeValue::INT_ELEMENTS);
+    r.array().int_elements = std::move(elements);
+    return r;
+  }
+
+  static RuntimeValue float_array(std::vector<double> elements)
+  {
+    RuntimeValue r = RuntimeValue::TypedArray(RuntimeValue::FLOAT_ELEMENTS);
+    r.array().float_elements = std::move(elements);
+    return r;
+  }
+
+  // A sparse operand (a sparse array, or a view of one) as its written
+  // elements only, in index order; every other index reads as 'hole'. The
+  // operators below work on these so the holes are never allocated.
+  struct SPARSE_SPAN
+  {
+    size_t length = 0;           // holes included
+    std::vector<size_t> indices; // of the written elements
+    std::vector<RuntimeValue> written;
+    RuntimeValue hole;
+
+    size_t holes() const { return length - indices.size(); }
+  };
+
+  static bool sparse_span(const RuntimeValue &v, SPARSE_SPAN &span)
+  {
+    if (v.type != RuntimeValue::ARRAY || v.is_grid())
+      return false;
+    const RuntimeValue *storage = v.is_view() ? v.array().view_source.get() : &v;
+    if (!storage->array().sparse)
+      return false;
+    size_t offset = v.is_view() ? v.array().view_offset : 0;
+    span.length = v.flat_length();
+    std::vector<std::pair<size_t, size_t>> slots; // index, slot
+    for (auto &entry : storage->array().sparse_slots)
+      if (entry.first >= offset && entry.first - offset < span.length)
+        slots.push_back({entry.first - offset, entry.second});
+    std::sort(slots.begin(), slots.end());
+    for (auto &slot : slots)
+    {
+      span.indices.push_back(slot.first);
+      span.written.push_back(storage->slot_get(slot.second));
     }
+    span.hole = storage->hole_value();
+    return true;
   }
-  // [NEW] Bitwise Implementation
-  void visit(BITWISE_EXPRESSION *expr) override
+
+  // Largest sparse operand an operator fills in densely, when the holes of
+  // the result would not be zero (a + 1); past it that is an error
+  static constexpr size_t MAX_FILLED_SPARSE = size_t(1) << 24;
+
+  // x OP y for two numbers, as one element of apply_elementwise
+  RuntimeValue element_op(enum type op, const RuntimeValue &x, const RuntimeValue &y)
   {
-    expr->left_operand->accept(this);
-    long long left = last_evaluated_value.int_val; // Assumes Type Checker guaranteed ints
-    expr->right_operand->accept(this);
-    long long right = last_evaluated_value.int_val;
+    if (!is_number(x) || !is_number(y))
+    {
+      std::cerr << "Runtime Error: Array operations need arrays of numbers." << std::endl;
+      exit(1);
+    }
+    if (op < TOKEN_BITWISE_AND || op > TOKEN_RIGHT_SHIFT)
+      return apply_binary(op, x, y);
+    if (x.type == RuntimeValue::FLOAT || y.type == RuntimeValue::FLOAT)
+    {
+      std::cerr << "Runtime Error: Bitwise operators need int arrays." << std::endl;
+      exit(1);
+    }
+    return apply_bitwise(op, x.int_val, y.int_val);
+  }
+
+  static bool is_zero(const RuntimeValue &v)
+  {
+    return (v.type == RuntimeValue::INT && v.int_val == 0) || (v.type == RuntimeValue::FLOAT && v.float_val == 0.0) ||
+           (v.type == RuntimeValue::BOOL && !v.bool_val);
+  }
 
-    switch (expr->operator_token.TYPE)
+  // apply_elementwise when no operand is a dense array: a sparse result
+  // holding only the indices written in either operand, if the holes
+  // combine to zero. False when they do not and the operand is small
+  // enough to fill in densely instead.
+  bool sparse_elementwise(enum type op, const RuntimeValue &left, const RuntimeValue &right, RuntimeValue &result)
+  {
+    SPARSE_SPAN x, y;
+    bool x_sparse = sparse_span(left, x), y_sparse = sparse_span(right, y);
+    size_t length = x_sparse ? x.length : y.length;
+    RuntimeValue fill = element_op(op, x_sparse ? x.hole : left, y_sparse ? y.hole : right);
+    if (!is_zero(fill))
+    {
+      if (length <= MAX_FILLED_SPARSE)
+        return false;
+      std::cerr << "Runtime Error: Array operation would fill the " << length
+                << " elements of a sparse array; apply it to the elements written instead." << std::endl;
+      exit(1);
+    }
+
+    // Both index lists are sorted: walk them together
+    result = RuntimeValue::TypedArray(fill.type == RuntimeValue::INT     ? RuntimeValue::INT_ELEMENTS
+                                      : fill.type == RuntimeValue::FLOAT ? RuntimeValue::FLOAT_ELEMENTS
+                                                                         : RuntimeValue::BOOL_ELEMENTS);
+    result.make_sparse(length);
+    size_t i = 0, j = 0;
+    while (i < x.indices.size() || j < y.indices.size())
+    {
+      size_t index = std::min(i < x.indices.size() ? x.indices[i] : SIZE_MAX, j < y.indices.size() ? y.indices[j] : SIZE_MAX);
+      const RuntimeValue &a = !x_sparse ? left : i < x.indices.size() && x.indices[i] == index ? x.written[i++] : x.hole;
+      const RuntimeValue &b = !y_sparse ? right : j < y.indices.size() && y.indices[j] == index ? y.written[j++] : y.hole;
+      RuntimeValue value = element_op(op, a, b);
+      if (!result.storage_accepts(value))
+        result.convert_storage(RuntimeValue::BOXED);
+      result.flat_set(index, value);
+    }
+    return true;
+  }
+
+  // a OP b where either side is an array (the other may be a number): a
+  // new array of the results. Each element follows apply_binary /
+  // apply_bitwise, so int OP int stays int and comparisons give bool[].
+  RuntimeValue apply_elementwise(enum type op, const RuntimeValue &left, const RuntimeValue &right)
+  {
+    size_t length = (left.type == RuntimeValue::ARRAY ? left : right).flat_length();
+    if (left.type == RuntimeValue::ARRAY && right.type == RuntimeValue::ARRAY && right.flat_length() != length)
+    {
+      std::cerr << "Runtime Error: Array operation on arrays of different lengths (" << length << " and "
+                << right.flat_length() << ")." << std::endl;
+      exit(1);
+    }
+    // Sparse operands stay sparse unless a dense array is involved anyway
+    bool left_dense = left.type == RuntimeValue::ARRAY && !is_sparse(left);
+    bool right_dense = right.type == RuntimeValue::ARRAY && !is_sparse(right);
+    RuntimeValue sparse_result;
+    if (!left_dense && !right_dense && sparse_elementwise(op, left, right, sparse_result))
+      return sparse_result;
+
+    NUMERIC_SPAN x, y;
+    numeric_span(left, length, x);
+    numeric_span(right, length, y);
+
+    if (op >= TOKEN_DOUBLE_EQUALS && op <= TOKEN_GREATER_EQUAL)
+    {
+      static const VECTOR_KERNELS::COMPARISON comparisons[] = {VECTOR_KERNELS::EQUAL, VECTOR_KERNELS::NOT_EQUAL, VECTOR_KERNELS::LESS,
+                                                               VECTOR_KERNELS::LESS_EQUAL, VECTOR_KERNELS::GREATER, VECTOR_KERNELS::GREATER_EQUAL};
+      std::vector<unsigned char> results(length);
+      VECTOR_KERNELS::compare(comparisons[op - TOKEN_DOUBLE_EQUALS], x.as_floats(), y.as_floats(), results.data(), length);
+      RuntimeValue r = RuntimeValue::TypedArray(RuntimeValue::BOOL_ELEMENTS);
+      r.array().bool_elements.assign(results.begin(), results.end());
+      return r;
+    }
+
+    VECTOR_KERNELS::OP kernel;
+    switch (op)
     {
+    case TOKEN_PLUS:
+      kernel = VECTOR_KERNELS::ADD;
+      break;
+    case TOKEN_MINUS:
+      kernel = VECTOR_KERNELS::SUBTRACT;
+      break;
+    case TOKEN_ASTERISK:
+      kernel = VECTOR_KERNELS::MULTIPLY;
+      break;
+    case TOKEN_SLASH:
+      kernel = VECTOR_KERNELS::DIVIDE;
+      break;
     case TOKEN_BITWISE_AND:
-      last_evaluated_value = RuntimeValue::Integer(left & right);
+      kernel = VECTOR_KERNELS::BIT_AND;
       break;
     case TOKEN_BITWISE_OR:
-      last_evaluated_value = RuntimeValue::Integer(left | right);
+      kernel = VECTOR_KERNELS::BIT_OR;
       break;
     case TOKEN_BITWISE_XOR:
-      last_evaluated_value = RuntimeValue::Integer(left ^ right);
+      kernel = VECTOR_KERNELS::BIT_XOR;
       break;
     case TOKEN_LEFT_SHIFT:
-      last_evaluated_value = RuntimeValue::Integer(left << right);
+      kernel = VECTOR_KERNELS::SHIFT_LEFT;
       break;
     case TOKEN_RIGHT_SHIFT:
-      last_evaluated_value = RuntimeValue::Integer(left >> right);
+      kernel = VECTOR_KERNELS::SHIFT_RIGHT;
       break;
     default:
-      break;
+      std::cerr << "Runtime Error: Operator not supported on arrays." << std::endl;
+      exit(1);
+    }
+    if (kernel == VECTOR_KERNELS::DIVIDE)
+    {
+      bool zero = false;
+      for (size_t k = 0; k < length && !zero; k++)
+        zero = y.is_float ? y.floats[k] == 0 : y.ints[k] == 0;
+      if (zero)
+      {
+        std::cerr << "Runtime Error: Division by zero." << std::endl;
+        exit(1);
+      }
+    }
+
+    if (!x.is_float && !y.is_float)
+    {
+      std::vector<long long> results(length);
+      VECTOR_KERNELS::apply(kernel, x.ints, y.ints, results.data(), length);
+      return int_array(std::move(results));
+    }
+    if (kernel >= VECTOR_KERNELS::BIT_AND)
+    {
+      std::cerr << "Runtime Error: Bitwise operators need int arrays." << std::endl;
+      exit(1);
     }
+    std::vector<double> results(length);
+    VECTOR_KERNELS::apply(kernel, x.as_floats(), y.as_floats(), results.data(), length);
+    return float_array(std::move(results));
   }
 
-  // [NEW] Increment/Decrement Implementation
-  void visit(INCREMENT_EXPRESSION *expr) override
+  // a == b on two arrays: the same length, and each element == the other's
+  // (so [1, 2] == [1.0, 2.0]); nested arrays are compared the same way
+  bool arrays_equal(const RuntimeValue &a, const RuntimeValue &b)
+  {
+    size_t length = a.array_length();
+    if (b.array_length() != length)
+      return false;
+    size_t a_offset, b_offset;
+    const RuntimeValue *x = numeric_elements(a, a_offset), *y = numeric_elements(b, b_offset);
+    if (x && y && x->array().array_storage == y->array().array_storage)
+    {
+      if (x->array().array_storage == RuntimeValue::INT_ELEMENTS)
+        return std::equal(x->array().int_elements.begin() + a_offset, x->array().int_elements.begin() + a_offset + length,
+                          y->array().int_elements.begin() + b_offset);
+      return std::equal(x->array().float_elements.begin() + a_offset, x->array().float_elements.begin() + a_offset + length,
+                        y->array().float_elements.begin() + b_offset);
+    }
+    SPARSE_SPAN xs, ys;
+    if (sparse_span(a, xs) && sparse_span(b, ys))
+    {
+      // Only indices written in either one can differ, besides the holes
+      if (xs.holes() > 0 && ys.holes() > 0 && !apply_binary(TOKEN_DOUBLE_EQUALS, xs.hole, ys.hole).bool_val)
+        return false;
+      size_t i = 0, j = 0;
+      while (i < xs.indices.size() || j < ys.indices.size())
+      {
+        size_t index = std::min(i < xs.indices.size() ? xs.indices[i] : SIZE_MAX, j < ys.indices.size() ? ys.indices[j] : SIZE_MAX);
+        const RuntimeValue &p = i < xs.indices.size() && xs.indices[i] == index ? xs.written[i++] : xs.hole;
+        const RuntimeValue &q = j < ys.indices.size() && ys.indices[j] == index ? ys.written[j++] : ys.hole;
+        if (!elements_equal(p, q))
+          return false;
+      }
+      return true;
+    }
+    for (size_t i = 0; i < length; i++)
+      if (!elements_equal(a.array_get(i), b.array_get(i)))
+        return false;
+    return true;
+  }
+
+  bool elements_equal(const RuntimeValue &p, const RuntimeValue &q)
   {
-    VARIABLE_EXPRESSION *varExpr = dynamic_cast<VARIABLE_EXPRESSION *>(expr->variable);
-    RuntimeValue currentVal = current_environment->get(varExpr->name.VALUE);
+    if (p.type == RuntimeValue::ARRAY || q.type == RuntimeValue::ARRAY)
+      return p.type == q.type && arrays_equal(p, q);
+    return apply_binary(TOKEN_DOUBLE_EQUALS, p, q).bool_val;
+  }
 
-    long long original = currentVal.int_val; // Assuming Int for simplicity
-    long long updated = (expr->operator_token.TYPE == TOKEN_INCREMENT) ? original + 1 : original - 1;
+  // sum(a), min(a), max(a) and dot(a, b)
+  RuntimeValue reduce_array(const std::string &name, CALL_EXPRESSION *expr)
+  {
+    std::vector<RuntimeValue> args;
+    for (auto arg : expr->arguments)
+    {
+      arg->accept(this);
+      args.push_back(std::move(last_evaluated_value));
+    }
+    if (is_sparse(args[0]) || (name == "dot" && is_sparse(args[1])))
+      return reduce_sparse(name, args);
 
-    current_environment->assign(varExpr->name.VALUE, RuntimeValue::Integer(updated));
+    NUMERIC_SPAN x, y;
+    numeric_span(args[0], 0, x);
+    if (name == "dot")
+    {
+      numeric_span(args[1], 0, y);
+      if (x.length != y.length)
+      {
+        std::cerr << "Runtime Error: dot() of arrays of different lengths (" << x.length << " and " << y.length << ")." << std::endl;
+        exit(1);
+      }
+      if (!x.is_float && !y.is_float)
+        return RuntimeValue::Integer(VECTOR_KERNELS::dot(x.ints, y.ints, x.length));
+      return RuntimeValue::Float(VECTOR_KERNELS::dot(x.as_floats(), y.as_floats(), x.length));
+    }
+    if (name == "sum")
+      return x.is_float ? RuntimeValue::Float(VECTOR_KERNELS::sum(x.floats, x.length)) : RuntimeValue::Integer(VECTOR_KERNELS::sum(x.ints, x.length));
 
-    // Prefix returns new value, Postfix returns old value
-    last_evaluated_value = RuntimeValue::Integer(expr->is_prefix ? updated : original);
+    if (x.length == 0)
+    {
+      std::cerr << "Runtime Error: " << name << "() of an empty array." << std::endl;
+      exit(1);
+    }
+    bool largest = name == "max";
+    return x.is_float ? RuntimeValue::Float(VECTOR_KERNELS::extreme(largest, x.floats, x.length))
+                      : RuntimeValue::Integer(VECTOR_KERNELS::extreme(largest, x.ints, x.length));
   }
 
-  void visit(PRINT_STATEMENT *stmt) override
+  // reduce_array over a sparse operand: only the written elements are
+  // visited, and the holes (all zero) are counted once
+  RuntimeValue reduce_sparse(const std::string &name, std::vector<RuntimeValue> &args)
   {
-    stmt->expression->accept(this);
-    if (last_evaluated_value.type == RuntimeValue::INT)
-      std::cout << last_evaluated_value.int_val << std::endl;
-    else if (last_evaluated_value.type == RuntimeValue::FLOAT)
-      std::cout << last_evaluated_value.float_val << std::endl;
-    else if (last_evaluated_value.type == RuntimeValue::STRING)
-      std::cout << last_evaluated_value.string_val << std::endl;
-    else if (last_evaluated_value.type == RuntimeValue::BOOL)
-      std::cout << (last_evaluated_value.bool_val ? "true" : "false") << std::endl;
-    else if (last_evaluated_value.type == RuntimeValue::ARRAY)
-      std::cout << "[Array]" << std::endl;
+    SPARSE_SPAN x;
+    if (name == "dot")
+    {
+      // Multiply along the sparser operand; every other product is zero
+      SPARSE_SPAN y;
+      bool x_sparse = sparse_span(args[0], x), y_sparse = sparse_span(args[1], y);
+      size_t other_length = args[1].type == RuntimeValue::ARRAY ? args[1].flat_length() : 0;
+      if (args[0].flat_length() != other_length)
+      {
+        std::cerr << "Runtime Error: dot() of arrays of different lengths (" << args[0].flat_length() << " and " << other_length
+                  << ")." << std::endl;
+        exit(1);
+      }
+      bool swap = !x_sparse || (y_sparse && y.indices.size() < x.indices.size());
+      const SPARSE_SPAN &along = swap ? y : x;
+      const RuntimeValue &other = swap ? args[0] : args[1];
+      RuntimeValue total = has_float_storage(args[0]) || has_float_storage(args[1]) ? RuntimeValue::Float(0.0) : RuntimeValue::Integer(0);
+      for (size_t k = 0; k < along.indices.size(); k++)
+        total = element_op(TOKEN_PLUS, total, element_op(TOKEN_ASTERISK, along.written[k], other.flat_get(along.indices[k])));
+      return total;
+    }
+
+    sparse_span(args[0], x);
+    std::vector<RuntimeValue> elements = std::move(x.written);
+    if (x.holes() > 0)
+      elements.push_back(x.hole); // stands for every hole; adds nothing to a sum
+    NUMERIC_SPAN span;
+    numeric_span(RuntimeValue::Array(std::move(elements)), 0, span);
+    if (x.hole.type == RuntimeValue::FLOAT)
+      span.as_floats();
+    if (name == "sum")
+      return span.is_float ? RuntimeValue::Float(VECTOR_KERNELS::sum(span.floats, span.length))
+                           : RuntimeValue::Integer(VECTOR_KERNELS::sum(span.ints, span.length));
+    if (span.length == 0)
+    {
+      std::cerr << "Runtime Error: " << name << "() of an empty array." << std::endl;
+      exit(1);
+    }
+    bool largest = name == "max";
+    return span.is_float ? RuntimeValue::Float(VECTOR_KERNELS::extreme(largest, span.floats, span.length))
+                         : RuntimeValue::Integer(VECTOR_KERNELS::extreme(largest, span.ints, span.length));
   }
 
-  void visit(BLOCK_STATEMENT *stmt) override
+  // --- MATRICES ---
+  // A matrix is a grid: rows x columns cells in one row-major buffer.
+  // MATRIX_CELLS reads a grid's int/float cells in place; other storage
+  // (byte cells, boxed rows that pack into a grid) is copied out first.
+  struct MATRIX_CELLS
   {
-    ENVIRONMENT *prev = current_environment;
-    current_environment = new ENVIRONMENT(prev);
-    for (auto s : stmt->statements)
-      s->accept(this);
-    current_environment = prev;
+    size_t rows = 0, columns = 0;
+    NUMERIC_SPAN cells;
+    RuntimeValue packed; // boxed rows packed into a grid
+  };
+
+  static void matrix_cells(const RuntimeValue &v, const std::string &name, MATRIX_CELLS &m)
+  {
+    const RuntimeValue *grid = &v;
+    if (v.type == RuntimeValue::ARRAY && !v.is_grid())
+    {
+      m.packed = v;
+      m.packed.try_make_grid();
+      grid = &m.packed;
+    }
+    if (v.type != RuntimeValue::ARRAY || !grid->is_grid() || grid->array().array_storage == RuntimeValue::BOOL_ELEMENTS ||
+        grid->array().array_storage == RuntimeValue::BOXED)
+    {
+      std::cerr << "Runtime Error: " << name << "() needs a rectangular matrix of numbers." << std::endl;
+      exit(1);
+    }
+    m.rows = grid->array().grid_rows;
+    m.columns = grid->array().grid_columns;
+    NUMERIC_SPAN &span = m.cells;
+    span.length = m.rows * m.columns;
+    span.is_float = grid->array().array_storage == RuntimeValue::FLOAT_ELEMENTS;
+    if (grid->array().sparse || grid->array().array_storage == RuntimeValue::BYTE_ELEMENTS)
+    {
+      for (size_t k = 0; k < span.length; k++)
+        span.int_copy.push_back(grid->flat_get(k).int_val);
+      span.ints = span.int_copy.data();
+    }
+    else if (span.is_float)
+      span.floats = grid->array().float_elements.data();
+    else
+      span.ints = grid->array().int_elements.data();
   }
 
-  void visit(IF_STATEMENT *stmt) override
+  static RuntimeValue make_matrix(RuntimeValue cells, size_t rows, size_t columns)
   {
-    stmt->condition_expression->accept(this);
-    if (is_truthy(last_evaluated_value))
-      stmt->then_branch_statement->accept(this);
-    else if (stmt->else_branch_statement)
-      stmt->else_branch_statement->accept(this);
+    cells.array().grid_rows = rows;
+    cells.array().grid_columns = columns;
+    return cells;
   }
 
-  // [NEW] Switch Statement
-  void visit(SWITCH_STATEMENT *stmt) override
+  // matrix(rows, columns), transpose(m) and matmul(a, b)
+  RuntimeValue matrix_builtin(const std::string &name, CALL_EXPRESSION *expr)
   {
-    stmt->value->accept(this);
-    RuntimeValue target = last_evaluated_value;
+    std::vector<RuntimeValue> args;
+    for (auto arg : expr->arguments)
+    {
+      arg->accept(this);
+      args.push_back(std::move(last_evaluated_value));
+    }
 
-    bool matched = false;
-    for (auto &c : stmt->cases)
+    if (name == "matrix")
     {
-      if (c.condition)
-      {
-        c.condition->accept(this);
-        // Simple equality check
-        if (last_evaluated_value.type == RuntimeValue::INT && target.type == RuntimeValue::INT)
-        {
-          if (last_evaluated_value.int_val == target.int_val)
-            matched = true;
-        }
-        else if (last_evaluated_value.type == RuntimeValue::STRING && target.type == RuntimeValue::STRING)
-        {
-          if (last_evaluated_value.string_val == target.string_val)
-            matched = true;
-        } // ... Add float check ...
-      }
-      else
+      long long rows = args[0].int_val, columns = args[1].int_val;
+      if (rows < 1 || columns < 1)
       {
-        // Default case matches if nothing else did
-        if (!matched)
-          matched = true;
+        std::cerr << "Runtime Error: matrix(" << rows << ", " << columns << ") needs positive dimensions." << std::endl;
+        exit(1);
       }
+      return make_matrix(float_array(std::vector<double>(rows * columns, 0.0)), rows, columns);
+    }
 
-      if (matched)
+    MATRIX_CELLS a;
+    matrix_cells(args[0], name, a);
+    if (name == "transpose")
+    {
+      if (a.cells.is_float)
       {
-        for (auto s : c.statements)
-          s->accept(this);
-        return; // Break switch after one successful case block
+        std::vector<double> out(a.cells.length);
+        MATRIX_KERNELS::transpose(a.cells.floats, out.data(), a.rows, a.columns);
+        return make_matrix(float_array(std::move(out)), a.columns, a.rows);
       }
+      std::vector<long long> out(a.cells.length);
+      MATRIX_KERNELS::transpose(a.cells.ints, out.data(), a.rows, a.columns);
+      return make_matrix(int_array(std::move(out)), a.columns, a.rows);
+    }
+
+    MATRIX_CELLS b;
+    matrix_cells(args[1], name, b);
+    if (a.columns != b.rows)
+    {
+      std::cerr << "Runtime Error: matmul() of a " << a.rows << "x" << a.columns << " and a " << b.rows << "x" << b.columns
+                << " matrix." << std::endl;
+      exit(1);
+    }
+    if (!a.cells.is_float && !b.cells.is_float)
+    {
+      std::vector<long long> out(a.rows * b.columns, 0);
+      MATRIX_KERNELS::multiply(a.cells.ints, b.cells.ints, out.data(), a.rows, a.columns, b.columns);
+      return make_matrix(int_array(std::move(out)), a.rows, b.columns);
     }
+    std::vector<double> out(a.rows * b.columns, 0.0);
+    MATRIX_KERNELS::multiply(a.cells.as_floats(), b.cells.as_floats(), out.data(), a.rows, a.columns, b.columns);
+    return make_matrix(float_array(std::move(out)), a.rows, b.columns);
   }
 
-  // [MODIFIED] Added Try-Catch for Break/Continue
-  void visit(WHILE_STATEMENT *stmt) override
+  // FINAL VERSION: Supports Int, Float, Bool, Byte, Short, Long, Double
+  // Shared by BINARY_EXPRESSION and compound assignment (x += v)
+  RuntimeValue apply_binary(enum type op, const RuntimeValue &left, const RuntimeValue &right)
   {
-    while (true)
+    // 0. WHOLE ARRAYS (a == b compares them whole; a + b, a * 2.0, a < b)
+    if (left.type == RuntimeValue::ARRAY && right.type == RuntimeValue::ARRAY && (op == TOKEN_DOUBLE_EQUALS || op == TOKEN_NOT_EQUALS))
+      return RuntimeValue::Bool(arrays_equal(left, right) == (op == TOKEN_DOUBLE_EQUALS));
+    if ((left.type == RuntimeValue::ARRAY && (right.type == RuntimeValue::ARRAY || is_number(right))) ||
+        (right.type == RuntimeValue::ARRAY && is_number(left)))
+      return apply_elementwise(op, left, right);
+
+    // 1. BOOLEAN COMPARISON FIX (Handle == and != for booleans)
+    if (left.type == RuntimeValue::BOOL && right.type == RuntimeValue::BOOL)
     {
-      stmt->condition_expression->accept(this);
-      if (!is_truthy(last_evaluated_value))
-        break;
+      if (op == TOKEN_DOUBLE_EQUALS)
+        return RuntimeValue::Bool(left.bool_val == right.bool_val);
+      if (op == TOKEN_NOT_EQUALS)
+        return RuntimeValue::Bool(left.bool_val != right.bool_val);
+      // Booleans don't support >, <, +, etc.
+      return right;
+    }
+
+    // 2. STRING CONCATENATION
+    if (op == TOKEN_PLUS)
+    {
+      if (left.type == RuntimeValue::STRING || right.type == RuntimeValue::STRING)
+      {
+        char l_buffer[NUMBER_FORMATTER::BUFFER_SIZE], r_buffer[NUMBER_FORMATTER::BUFFER_SIZE];
+        std::string_view l_str = concat_text(left, l_buffer);
+        std::string_view r_str = concat_text(right, r_buffer);
+        RUNTIME_STRING result;
+        result.reserve(l_str.size() + r_str.size());
+        result.append(l_str);
+        result.append(r_str);
+        return RuntimeValue::String(std::move(result));
+      }
+    }
+
+    // 2b. STRING COMPARISON (== on interned strings is an address check)
+    if (left.type == RuntimeValue::STRING && right.type == RuntimeValue::STRING)
+    {
+      switch (op)
+      {
+      case TOKEN_DOUBLE_EQUALS:
+        return RuntimeValue::Bool(left.string_val == right.string_val);
+      case TOKEN_NOT_EQUALS:
+        return RuntimeValue::Bool(left.string_val != right.string_val);
+      case TOKEN_LESS_THAN:
+        return RuntimeValue::Bool(left.string_val.view() < right.string_val.view());
+      case TOKEN_GREATER_THAN:
+        return RuntimeValue::Bool(left.string_val.view() > right.string_val.view());
+      case TOKEN_LESS_EQUAL:
+        return RuntimeValue::Bool(left.string_val.view() <= right.string_val.view());
+      case TOKEN_GREATER_EQUAL:
+        return RuntimeValue::Bool(left.string_val.view() >= right.string_val.view());
+      default:
+        return right;
+      }
+    }
+
+    // 3. NUMERIC MATH (Handles Byte, Short, Int, Long, Float, Double)
+    // We promote everything to 'double' for calculation if one side is float/double
+    // We promote everything to 'long long' if both sides are integers
+
+    double l_val = (left.type == RuntimeValue::INT) ? (double)left.int_val : left.float_val;
+    double r_val = (right.type == RuntimeValue::INT) ? (double)right.int_val : right.float_val;
+    bool are_ints = (left.type == RuntimeValue::INT && right.type == RuntimeValue::INT);
+
+    switch (op)
+    {
+    case TOKEN_PLUS:
+      if (are_ints)
+        return RuntimeValue::Integer(left.int_val + right.int_val);
+      return RuntimeValue::Float(l_val + r_val);
+
+    case TOKEN_MINUS:
+      if (are_ints)
+        return RuntimeValue::Integer(left.int_val - right.int_val);
+      return RuntimeValue::Float(l_val - r_val);
+
+    case TOKEN_ASTERISK:
+      if (are_ints)
+        return RuntimeValue::Integer(left.int_val * right.int_val);
+      return RuntimeValue::Float(l_val * r_val);
+
+    case TOKEN_SLASH:
+      if (r_val == 0)
+      {
+        std::cerr << "Runtime Error: Division by zero." << std::endl;
+        exit(1);
+      }
+      if (are_ints)
+        return RuntimeValue::Integer(left.int_val / right.int_val);
+      return RuntimeValue::Float(l_val / r_val);
+
+    case TOKEN_PERCENT:
+      if (are_ints)
+        return RuntimeValue::Integer(left.int_val % right.int_val);
+      std::cerr << "Runtime Error: Modulo on floats not supported." << std::endl;
+      exit(1);
+
+    case TOKEN_GREATER_THAN:
+      return RuntimeValue::Bool(l_val > r_val);
+    case TOKEN_LESS_THAN:
+      return RuntimeValue::Bool(l_val < r_val);
+    case TOKEN_GREATER_EQUAL:
+      return RuntimeValue::Bool(l_val >= r_val);
+    case TOKEN_LESS_EQUAL:
+      return RuntimeValue::Bool(l_val <= r_val);
+    case TOKEN_DOUBLE_EQUALS:
+      return RuntimeValue::Bool(l_val == r_val);
+    case TOKEN_NOT_EQUALS:
+      return RuntimeValue::Bool(l_val != r_val);
+    default:
+      return right;
+    }
+  }
+
+  void visit(BINARY_EXPRESSION *expr) override
+  {
+    expr->left_operand->accept(this);
+    RuntimeValue left = std::move(last_evaluated_value);
+    expr->right_operand->accept(this);
+    last_evaluated_value = apply_binary(expr->operator_token.TYPE, left, last_evaluated_value);
+  }
+
+  // Text of a value as string '+' writes it; numbers are formatted into
+  // buffer (NUMBER_FORMATTER::BUFFER_SIZE chars)
+  std::string_view concat_text(const RuntimeValue &value, char *buffer)
+  {
+    switch (value.type)
+    {
+    case RuntimeValue::STRING:
+      return value.string_val;
+    case RuntimeValue::INT:
+      return NUMBER_FORMATTER::format_int(value.int_val, buffer);
+    case RuntimeValue::BOOL:
+      return value.bool_val ? "true" : "false";
+    default:
+      return NUMBER_FORMATTER::format_float(value.float_val, buffer);
+    }
+  }
+
+  // Evaluates every part of a fused chain once. Leading non-string parts are
+  // added numerically, exactly as the nested '+' chain would; once a string
+  // shows up every remaining piece is appended as text.
+  void evaluate_concat_parts(CONCAT_EXPRESSION *expr, std::vector<RuntimeValue> &pieces)
+  {
+    pieces.reserve(expr->parts.size());
+    for (auto part : expr->parts)
+    {
+      part->accept(this);
+      if (pieces.size() == 1 && pieces[0].type != RuntimeValue::STRING && last_evaluated_value.type != RuntimeValue::STRING)
+        pieces[0] = apply_binary(TOKEN_PLUS, pieces[0], last_evaluated_value);
+      else
+        pieces.push_back(std::move(last_evaluated_value));
+    }
+  }
+
+  void visit(CONCAT_EXPRESSION *expr) override
+  {
+    std::vector<RuntimeValue> pieces;
+    evaluate_concat_parts(expr, pieces);
+    if (pieces.size() == 1)
+    {
+      last_evaluated_value = pieces[0];
+      return;
+    }
+
+    // Size the result first so it is written exactly once; a number never
+    // needs more than one formatting buffer
+    size_t total = 0;
+    for (auto &piece : pieces)
+      total += piece.type == RuntimeValue::STRING ? piece.string_val.size() : NUMBER_FORMATTER::BUFFER_SIZE;
+    RUNTIME_STRING result;
+    result.reserve(total);
+    char buffer[NUMBER_FORMATTER::BUFFER_SIZE];
+    for (auto &piece : pieces)
+      result.append(concat_text(piece, buffer));
+    last_evaluated_value = RuntimeValue::String(std::move(result));
+  }
+
+  // [NEW] Bitwise Implementation
+  // Shared by BITWISE_EXPRESSION and compound assignment (x |= v)
+  RuntimeValue apply_bitwise(enum type op, long long left, long long right) // Assumes Type Checker guaranteed ints
+  {
+    switch (op)
+    {
+    case TOKEN_BITWISE_AND:
+      return RuntimeValue::Integer(left & right);
+    case TOKEN_BITWISE_OR:
+      return RuntimeValue::Integer(left | right);
+    case TOKEN_BITWISE_XOR:
+      return RuntimeValue::Integer(left ^ right);
+    case TOKEN_LEFT_SHIFT:
+      return RuntimeValue::Integer(left << right);
+    case TOKEN_RIGHT_SHIFT:
+      return RuntimeValue::Integer(left >> right);
+    default:
+      return RuntimeValue::Integer(right);
+    }
+  }
+
+  void visit(BITWISE_EXPRESSION *expr) override
+  {
+    expr->left_operand->accept(this);
+    if (last_evaluated_value.type == RuntimeValue::ARRAY)
+    {
+      RuntimeValue left = std::move(last_evaluated_value);
+      expr->right_operand->accept(this);
+      last_evaluated_value = apply_elementwise(expr->operator_token.TYPE, left, last_evaluated_value);
+      return;
+    }
+    long long left = last_evaluated_value.int_val;
+    expr->right_operand->accept(this);
+    if (last_evaluated_value.type == RuntimeValue::ARRAY)
+      last_evaluated_value = apply_elementwise(expr->operator_token.TYPE, RuntimeValue::Integer(left), last_evaluated_value);
+    else
+      last_evaluated_value = apply_bitwise(expr->operator_token.TYPE, left, last_evaluated_value.int_val);
+  }
+
+  // [NEW] Increment/Decrement Implementation
+  // Works on any target (i++, a[i]++, obj.count++), updated in place
+  void visit(INCREMENT_EXPRESSION *expr) override
+  {
+    LOCATION loc = resolve_location(expr->variable);
+    RuntimeValue original = read_location(loc);
+
+    long long step = (expr->operator_token.TYPE == TOKEN_INCREMENT) ? 1 : -1;
+    RuntimeValue updated = (original.type == RuntimeValue::FLOAT)
+                               ? RuntimeValue::Float(original.float_val + step)
+                               : RuntimeValue::Integer(original.int_val + step);
+    write_location(loc, updated);
+
+    // Prefix returns new value, Postfix returns old value
+    last_evaluated_value = expr->is_prefix ? updated : original;
+  }
+
+  // Compound assignment: target is resolved once, read, combined and
+  // written back in place
+  void visit(COMPOUND_ASSIGNMENT_EXPRESSION *expr) override
+  {
+    if (expr->appends_to_target)
+    {
+      RuntimeValue *target = current_environment->lookup(static_cast<VARIABLE_EXPRESSION *>(expr->target)->name.VALUE);
+      if (target->type == RuntimeValue::STRING)
+      {
+        expr->value_expression->accept(this);
+        append_in_place(*target, {std::move(last_evaluated_value)});
+        return;
+      }
+    }
+
+    LOCATION loc = resolve_location(expr->target);
+    RuntimeValue current = read_location(loc);
+
+    expr->value_expression->accept(this);
+    enum type op = expr->operator_token.TYPE;
+    bool bitwise = op >= TOKEN_BITWISE_AND && op <= TOKEN_RIGHT_SHIFT;
+    RuntimeValue result = (bitwise && (current.type == RuntimeValue::ARRAY || last_evaluated_value.type == RuntimeValue::ARRAY))
+                              ? apply_elementwise(op, current, last_evaluated_value)
+                          : bitwise ? apply_bitwise(op, current.int_val, last_evaluated_value.int_val)
+                                    : apply_binary(op, current, last_evaluated_value);
+
+    // Re-walk: the right-hand side may have reallocated arrays on the path
+    write_location(loc, result);
+    last_evaluated_value = result;
+  }
+
+  void visit(PRINT_STATEMENT *stmt) override
+  {
+    // Lines end with '\n', not std::endl: the OUTPUT_WRITER behind
+    // std::cout decides when buffered output reaches stdout. (A worker of
+    // a parallel loop prints into its chunk's buffer instead.)
+    // print "a" + b + "c": stream each piece instead of building the string
+    if (stmt->expression->kind == NODE_CONCAT_EXPRESSION)
+    {
+      std::vector<RuntimeValue> pieces;
+      evaluate_concat_parts(static_cast<CONCAT_EXPRESSION *>(stmt->expression), pieces);
+      if (pieces.size() > 1)
+      {
+        char buffer[NUMBER_FORMATTER::BUFFER_SIZE];
+        for (auto &piece : pieces)
+        {
+          std::string_view text = concat_text(piece, buffer);
+          output->write(text.data(), text.size());
+        }
+        output->put('\n');
+        return;
+      }
+      last_evaluated_value = pieces[0];
+    }
+    else
+      stmt->expression->accept(this);
+
+    // Numbers, strings and bools print exactly as string '+' would write them
+    RuntimeValue::ValType value_type = last_evaluated_value.type;
+    if (value_type == RuntimeValue::INT || value_type == RuntimeValue::FLOAT ||
+        value_type == RuntimeValue::STRING || value_type == RuntimeValue::BOOL)
+    {
+      char buffer[NUMBER_FORMATTER::BUFFER_SIZE];
+      std::string_view text = concat_text(last_evaluated_value, buffer);
+      output->write(text.data(), text.size());
+      output->put('\n');
+    }
+    else if (value_type == RuntimeValue::ARRAY)
+      *output << "[Array]\n";
+    else if (value_type == RuntimeValue::MAP)
+      *output << "[Map]\n";
+  }
+
+  // Puts back the enclosing environment when a scope is left, also when a
+  // break, continue or return unwinds through it
+  struct SCOPE_EXIT
+  {
+    ENVIRONMENT *&current;
+    ENVIRONMENT *saved;
+    ~SCOPE_EXIT() { current = saved; }
+  };
+
+  void visit(BLOCK_STATEMENT *stmt) override
+  {
+    ENVIRONMENT scope(current_environment);
+    SCOPE_EXIT restore{current_environment, current_environment};
+    current_environment = &scope;
+    for (auto s : stmt->statements)
+      s->accept(this);
+  }
+
+  void visit(IF_STATEMENT *stmt) override
+  {
+    stmt->condition_expression->accept(this);
+    if (is_truthy(last_evaluated_value))
+      stmt->then_branch_statement->accept(this);
+    else if (stmt->else_branch_statement)
+      stmt->else_branch_statement->accept(this);
+  }
+
+  // [NEW] Switch Statement
+  void visit(SWITCH_STATEMENT *stmt) override
+  {
+    stmt->value->accept(this);
+    RuntimeValue target = last_evaluated_value;
+
+    bool matched = false;
+    for (auto &c : stmt->cases)
+    {
+      if (c.condition)
+      {
+        c.condition->accept(this);
+        // Simple equality check
+        if (last_evaluated_value.type == RuntimeValue::INT && target.type == RuntimeValue::INT)
+        {
+          if (last_evaluated_value.int_val == target.int_val)
+            matched = true;
+        }
+        else if (last_evaluated_value.type == RuntimeValue::STRING && target.type == RuntimeValue::STRING)
+        {
+          if (last_evaluated_value.string_val == target.string_val)
+            matched = true;
+        } // ... Add float check ...
+      }
+      else
+      {
+        // Default case matches if nothing else did
+        if (!matched)
+          matched = true;
+      }
+
+      if (matched)
+      {
+        for (auto s : c.statements)
+          s->accept(this);
+        return; // Break switch after one successful case block
+      }
+    }
+  }
+
+  // [MODIFIED] Added Try-Catch for Break/Continue
+  void visit(WHILE_STATEMENT *stmt) override
+  {
+    while (true)
+    {
+      stmt->condition_expression->accept(this);
+      if (!is_truthy(last_evaluated_value))
+        break;
+
+      try
+      {
+        stmt->body_statement->accept(this);
+      }
+      catch (BreakException)
+      {
+        break;
+      }
+      catch (ContinueException)
+      {
+        continue;
+      }
+    }
+  }
+
+  // [NEW] Loop Controls
+  void visit(BREAK_STATEMENT *stmt) override { throw BreakException(); }
+  void visit(CONTINUE_STATEMENT *stmt) override { throw ContinueException(); }
+
+  void visit(FOR_STATEMENT *stmt) override
+  {
+    ENVIRONMENT scope(current_environment); // Scope for initializer
+    SCOPE_EXIT restore{current_environment, current_environment};
+    current_environment = &scope;
+
+    // 1. Run Initializer
+    if (stmt->initializer)
+      stmt->initializer->accept(this);
+
+    if (stmt->vector_loop && run_vector_loop(stmt))
+      return;
+    if (stmt->parallel)
+    {
+      run_parallel_loop(stmt);
+      return;
+    }
+    if (stmt->counted_step != 0 && run_counted_loop(stmt))
+      return;
+
+    while (true)
+    {
+      // 2. Check Condition
+      if (stmt->condition)
+      {
+        stmt->condition->accept(this);
+        if (!is_truthy(last_evaluated_value))
+          break;
+      }
+
+      // 3. Run Body
+      try
+      {
+        stmt->body->accept(this);
+      }
+      catch (const BreakException &)
+      {
+        break; // Stop loop entirely
+      }
+      catch (const ContinueException &)
+      {
+        // Catch it, but DO NOTHING.
+        // Just let execution fall through to step 4 (Increment).
+      }
+
+      // 4. Run Increment (This runs even after continue!)
+      if (stmt->increment)
+        stmt->increment->accept(this);
+    }
+  }
+
+  // for (int i = a; i < b; i++) once the initializer has run (see
+  // FOR_STATEMENT::counted_step). The counter is the int64 in i's own slot,
+  // compared and stepped natively; the body reads and writes it there as
+  // usual. The bound is re-read from its storage each iteration, so a body
+  // that changes n or pushes to v is still followed. False, before the
+  // first iteration, when i or the bound is not an int at runtime.
+  bool run_counted_loop(FOR_STATEMENT *stmt)
+  {
+    auto declaration = static_cast<VARIABLE_DECLARATION_STATEMENT *>(stmt->initializer);
+    auto condition = static_cast<BINARY_EXPRESSION *>(stmt->condition);
+    RuntimeValue *counter = current_environment->lookup(declaration->name_token.VALUE);
+    if (counter->type != RuntimeValue::INT)
+      return false;
+
+    // The bound: an int literal, an int variable, or v.length
+    long long literal_bound = 0;
+    const long long *bound = &literal_bound;
+    const RuntimeValue *measured = nullptr;
+    EXPRESSION *limit = condition->right_operand;
+    if (limit->kind == NODE_LITERAL_EXPRESSION)
+    {
+      limit->accept(this);
+      if (last_evaluated_value.type != RuntimeValue::INT)
+        return false;
+      literal_bound = last_evaluated_value.int_val;
+    }
+    else if (limit->kind == NODE_VARIABLE_EXPRESSION)
+    {
+      const RuntimeValue *slot = current_environment->lookup(static_cast<VARIABLE_EXPRESSION *>(limit)->name.VALUE);
+      if (slot->type != RuntimeValue::INT)
+        return false;
+      bound = &slot->int_val;
+    }
+    else
+    {
+      auto object = static_cast<VARIABLE_EXPRESSION *>(static_cast<GET_EXPRESSION *>(limit)->object_expression);
+      measured = current_environment->lookup(object->name.VALUE);
+      if (measured->type != RuntimeValue::ARRAY && measured->type != RuntimeValue::STRING)
+        return false;
+    }
+
+    long long &i = counter->int_val;
+    enum type op = condition->operator_token.TYPE;
+    while (true)
+    {
+      long long end = *bound;
+      if (measured)
+        end = measured->type == RuntimeValue::ARRAY ? (long long)measured->array_length() : (long long)measured->string_val.size();
+      if (!(op == TOKEN_LESS_THAN ? i < end : op == TOKEN_LESS_EQUAL ? i <= end : op == TOKEN_GREATER_THAN ? i > end : i >= end))
+        break;
+      try
+      {
+        stmt->body->accept(this);
+      }
+      catch (const BreakException &)
+      {
+        break;
+      }
+      catch (const ContinueException &)
+      {
+      }
+      i += stmt->counted_step;
+    }
+    return true;
+  }
+
+  // --- PARALLEL LOOPS ---
+  // parallel for (see parallel_loop.hpp), once the initializer has run. The
+  // iterations are cut into at most PARALLEL_CHUNKS runs of consecutive
+  // counter values, by their count alone. A chunk runs in a frame of its
+  // own below the loop's scope, holding its counter and its partial
+  // reductions, and prints into a buffer of its own; the pool threads take
+  // chunks with a worker INTERPRETER each. Before they start, every array
+  // the body writes at a[i] gets storage of its own, down to its rows, and
+  // every other array variable in sight becomes a view (see VIEWS), so
+  // between them the workers only read shared storage, besides their own
+  // a[i]. When a written array cannot be shared that way (it is too short
+  // for the counter and would grow, sparse, or packs its elements as bits
+  // or bytes) the chunks run one after the other on this thread, to the
+  // same result. (A loop VECTOR_LOOP handles never gets here.)
+  static constexpr long long PARALLEL_CHUNKS = 256;
+
+  void run_parallel_loop(FOR_STATEMENT *stmt)
+  {
+    const PARALLEL_LOOP &plan = *stmt->parallel;
+    auto condition = static_cast<BINARY_EXPRESSION *>(stmt->condition);
+    long long start = current_environment->lookup(plan.counter)->int_val;
+
+    // The last counter value the condition lets through; the body cannot
+    // change the bound
+    condition->right_operand->accept(this);
+    const RuntimeValue &bound = last_evaluated_value;
+    enum type op = condition->operator_token.TYPE;
+    long long last;
+    if (bound.type == RuntimeValue::INT)
+      last = op == TOKEN_LESS_THAN ? bound.int_val - 1 : op == TOKEN_GREATER_THAN ? bound.int_val + 1 : bound.int_val;
+    else if (bound.type == RuntimeValue::FLOAT)
+      last = op == TOKEN_LESS_THAN ? (long long)std::ceil(bound.float_val) - 1 : op == TOKEN_LESS_EQUAL ? (long long)std::floor(bound.float_val)
+             : op == TOKEN_GREATER_THAN ? (long long)std::floor(bound.float_val) + 1 : (long long)std::ceil(bound.float_val);
+    else
+    {
+      std::cerr << "Runtime Error: Parallel loop bound is not a number." << std::endl;
+      exit(1);
+    }
+    long long count = plan.step > 0 ? last - start + 1 : start - last + 1;
+    if (count <= 0)
+      return;
+    long long chunks = std::min(count, PARALLEL_CHUNKS);
+
+    std::vector<RuntimeValue *> regrid;
+    bool threaded = WORK_STEALING_POOL::threads() > 1 && prepare_parallel_arrays(plan, std::min(start, last), std::max(start, last), regrid);
+
+    std::vector<std::vector<RuntimeValue>> partials(chunks);
+    auto chunk_start = [&](long long c) { return start + count * c / chunks * plan.step; };
+    auto chunk_length = [&](long long c) { return count * (c + 1) / chunks - count * c / chunks; };
+    if (!threaded)
+    {
+      for (long long c = 0; c < chunks; c++)
+        run_parallel_chunk(stmt, current_environment, chunk_start(c), chunk_length(c), *output, partials[c]);
+    }
+    else
+    {
+      WORK_STEALING_POOL &pool = WORK_STEALING_POOL::instance();
+      while (parallel_workers.size() < pool.size())
+        parallel_workers.emplace_back(new INTERPRETER(this));
+      std::vector<const RuntimeValue *> written(parallel_written);
+      for (auto &worker : parallel_workers)
+      {
+        worker->functions = functions;
+        worker->classes = classes;
+        worker->structs = structs;
+        worker->parallel_written.swap(written);
+        written = worker->parallel_written;
+      }
+      parallel_written.clear();
+
+      std::vector<std::ostringstream> printed(chunks);
+      ENVIRONMENT *loop_scope = current_environment;
+      pool.run(chunks, [&](size_t c, size_t w)
+               {
+                 try
+                 {
+                   parallel_workers[w]->run_parallel_chunk(stmt, loop_scope, chunk_start(c), chunk_length(c), printed[c], partials[c]);
+                 }
+                 catch (const std::bad_alloc &)
+                 {
+                   out_of_memory();
+                 } });
+      for (auto &worker : parallel_workers)
+        worker->parallel_written.clear();
+      for (auto &text : printed)
+      {
+        std::string chunk_output = text.str();
+        output->write(chunk_output.data(), chunk_output.size());
+      }
+    }
+    for (auto array : regrid)
+      array->try_make_grid();
+
+    // Fold the partials into the variables, in chunk order
+    for (size_t k = 0; k < plan.reductions.size(); k++)
+    {
+      RuntimeValue *total = current_environment->lookup(plan.reductions[k].name);
+      for (auto &chunk : partials)
+      {
+        if (total->type == RuntimeValue::STRING)
+          total->string_val.append(chunk[k].string_val);
+        else
+          *total = apply_binary(plan.reductions[k].op, *total, chunk[k]);
+      }
+    }
+  }
+
+  // Readies the arrays the loop writes at a[i], for i in [low, high], to be
+  // written by several threads at once (listing them in parallel_written);
+  // false if one cannot be. Grids are split into rows, to be packed again
+  // (regrid) after the loop.
+  bool prepare_parallel_arrays(const PARALLEL_LOOP &plan, long long low, long long high, std::vector<RuntimeValue *> &regrid)
+  {
+    parallel_written.clear();
+    for (auto &name : plan.written)
+    {
+      RuntimeValue *array = current_environment->lookup(name);
+      if (array->type != RuntimeValue::ARRAY || array->array().sparse || low < 0 || high >= (long long)array->array_length())
+        return false;
+      if (array->is_grid())
+      {
+        array->split_grid();
+        regrid.push_back(array);
+      }
+      if (array->array().array_storage == RuntimeValue::BOOL_ELEMENTS || array->array().array_storage == RuntimeValue::BYTE_ELEMENTS)
+        return false;
+      make_private(*array);
+      parallel_written.push_back(array);
+    }
+    for (ENVIRONMENT *env = current_environment; env; env = env->parent)
+      for (auto &entry : env->variables)
+        if (entry.second.type == RuntimeValue::ARRAY &&
+            std::find(parallel_written.begin(), parallel_written.end(), &entry.second) == parallel_written.end())
+          entry.second.share();
+    return true;
+  }
+
+  // Gives an array or map, and everything nested in it, storage that no
+  // other value shares
+  static void make_private(RuntimeValue &value)
+  {
+    if (value.type == RuntimeValue::MAP)
+    {
+      if (value.map_val.use_count() > 1)
+        value.map_val = std::make_shared<RuntimeMap>(*value.map_val);
+      make_private(value.map_val->values);
+    }
+    else if (value.type == RuntimeValue::ARRAY)
+    {
+      value.unshare();
+      if (value.array().array_storage == RuntimeValue::BOXED)
+        for (auto &element : value.array().array_elements)
+          make_private(element);
+    }
+  }
+
+  // Runs 'length' iterations from counter value 'from' in a frame below
+  // loop_scope, printing to 'out'; the frame's partial reductions are left
+  // in 'partials'
+  void run_parallel_chunk(FOR_STATEMENT *stmt, ENVIRONMENT *loop_scope, long long from, long long length, std::ostream &out,
+                          std::vector<RuntimeValue> &partials)
+  {
+    const PARALLEL_LOOP &plan = *stmt->parallel;
+    ENVIRONMENT frame(loop_scope);
+    for (auto &r : plan.reductions)
+    {
+      const RuntimeValue &total = *loop_scope->lookup(r.name);
+      bool times = r.op == TOKEN_ASTERISK;
+      frame.define(r.name, total.type == RuntimeValue::STRING ? RuntimeValue::String(RUNTIME_STRING())
+                           : total.type == RuntimeValue::FLOAT ? RuntimeValue::Float(times ? 1.0 : 0.0)
+                                                               : RuntimeValue::Integer(times ? 1 : 0));
+    }
+    frame.define(plan.counter, RuntimeValue::Integer(from));
+    RuntimeValue &counter = frame.variables[plan.counter];
+
+    ENVIRONMENT *saved_environment = current_environment;
+    std::ostream *saved_output = output;
+    current_environment = &frame;
+    output = &out;
+    for (long long k = 0; k < length; k++)
+    {
+      counter = RuntimeValue::Integer(from + k * stmt->parallel->step);
+      try
+      {
+        stmt->body->accept(this);
+      }
+      catch (const ContinueException &)
+      {
+      }
+    }
+    current_environment = saved_environment;
+    output = saved_output;
+    last_evaluated_value = RuntimeValue::Void(); // drop any share of the loop's values
+
+    for (auto &r : plan.reductions)
+      partials.push_back(std::move(frame.variables[r.name]));
+  }
+
+  // --- FOREACH LOOPS ---
+  // for (T x : collection). x has a scope of its own and is overwritten in
+  // place each iteration. The collection is evaluated once into a snapshot
+  // (an O(1) shared copy, see VIEWS; a body that writes the original copies
+  // it first), so its length is fixed and items are read straight from its
+  // storage with no index checks. A pipeline runs with the body as its end;
+  // a bare range() just counts in place.
+  void visit(FOREACH_STATEMENT *stmt) override
+  {
+    ENVIRONMENT scope(current_environment);
+    SCOPE_EXIT restore{current_environment, current_environment};
+    current_environment = &scope;
+    scope.define(stmt->name_token.VALUE, RuntimeValue::Void());
+    RuntimeValue *item = scope.lookup(stmt->name_token.VALUE);
+
+    // One iteration; false once the body breaks
+    auto run_body = [&]()
+    {
+      try
+      {
+        stmt->body->accept(this);
+      }
+      catch (const BreakException &)
+      {
+        return false;
+      }
+      catch (const ContinueException &)
+      {
+      }
+      return true;
+    };
+    auto set_int = [item](long long v)
+    {
+      if (item->type == RuntimeValue::INT)
+        item->int_val = v;
+      else
+        *item = RuntimeValue::Integer(v);
+    };
+
+    PIPELINE *plan = stmt->pipeline;
+    if (plan && plan->source == PIPELINE::RANGE && plan->stages.empty())
+    {
+      for_each_in_range(plan->origin, [&](long long i)
+                        {
+                          set_int(i);
+                          return run_body(); });
+      return;
+    }
+    if (plan)
+    {
+      run_pipeline(*plan, [&](RuntimeValue &&value)
+                   {
+                     *item = std::move(value);
+                     return run_body(); });
+      return;
+    }
+
+    stmt->collection->accept(this);
+    RuntimeValue items = std::move(last_evaluated_value);
+    if (items.type == RuntimeValue::ARRAY)
+    {
+      size_t length = items.array_length(), offset = 0;
+      const RuntimeValue *storage = numeric_elements(items, offset);
+      if (storage && storage->array().array_storage == RuntimeValue::INT_ELEMENTS)
+      {
+        const long long *ints = storage->array().int_elements.data() + offset;
+        for (size_t i = 0; i < length; i++)
+        {
+          set_int(ints[i]);
+          if (!run_body())
+            break;
+        }
+      }
+      else if (storage)
+      {
+        const double *floats = storage->array().float_elements.data() + offset;
+        for (size_t i = 0; i < length; i++)
+        {
+          if (item->type == RuntimeValue::FLOAT)
+            item->float_val = floats[i];
+          else
+            *item = RuntimeValue::Float(floats[i]);
+          if (!run_body())
+            break;
+        }
+      }
+      else
+      {
+        for (size_t i = 0; i < length; i++)
+        {
+          *item = items.array_get(i);
+          if (!run_body())
+            break;
+        }
+      }
+    }
+    else if (items.type == RuntimeValue::STRING)
+    {
+      for (size_t i = 0; i < items.string_val.size(); i++)
+      {
+        *item = RuntimeValue::String(items.string_val.substr(i, 1));
+        if (!run_body())
+          break;
+      }
+    }
+    else if (items.type == RuntimeValue::MAP)
+    {
+      const RuntimeMap &map = *items.map_val;
+      for (size_t e = 0; e < map.entry_count(); e++)
+      {
+        if (!map.live[e])
+          continue;
+        *item = map.keys[e].value();
+        if (!run_body())
+          break;
+      }
+    }
+    else
+    {
+      std::cerr << "Runtime Error: Cannot iterate over this value." << std::endl;
+      exit(1);
+    }
+  }
+
+  // --- LAZY PIPELINES ---
+  // See pipeline.hpp. Nothing is evaluated until the end runs the plan.
+
+  // start, end and step of a range(...) call
+  void range_bounds(CALL_EXPRESSION *call, long long &start, long long &end, long long &step)
+  {
+    long long bounds[3] = {0, 0, 1};
+    for (size_t k = 0; k < call->arguments.size(); k++)
+    {
+      call->arguments[k]->accept(this);
+      bounds[call->arguments.size() == 1 ? 1 : k] = last_evaluated_value.int_val;
+    }
+    start = bounds[0], end = bounds[1], step = bounds[2];
+    if (step == 0)
+    {
+      std::cerr << "Runtime Error: range() step cannot be 0." << std::endl;
+      exit(1);
+    }
+  }
+
+  // Calls visit(i) for each value of a range(...) call in turn, until it
+  // returns false. The values are counted up front in unsigned arithmetic,
+  // so a range that ends near the limits of long long stops there instead
+  // of overflowing past them.
+  template <typename VISIT>
+  void for_each_in_range(CALL_EXPRESSION *call, VISIT visit)
+  {
+    long long start, end, step;
+    range_bounds(call, start, end, step);
+    if (step > 0 ? start >= end : start <= end)
+      return;
+    unsigned long long span = step > 0 ? (unsigned long long)end - (unsigned long long)start
+                                       : (unsigned long long)start - (unsigned long long)end;
+    unsigned long long stride = step > 0 ? (unsigned long long)step : 0ULL - (unsigned long long)step;
+    unsigned long long count = (span - 1) / stride + 1;
+    unsigned long long value = (unsigned long long)start; // wraps like two's complement, never past the last value
+    for (unsigned long long k = 0; k < count; k++, value += (unsigned long long)step)
+      if (!visit((long long)value))
+        return;
+  }
+
+  // The user function a map(), filter() or reduce() call names
+  FUNCTION_DECLARATION_STATEMENT *callback(CALL_EXPRESSION *call)
+  {
+    const std::string &name = static_cast<VARIABLE_EXPRESSION *>(call->arguments[0])->name.VALUE;
+    auto found = functions.find(name);
+    if (found == functions.end())
+    {
+      std::cerr << "Runtime Error: Undefined function '" << name << "'." << std::endl;
+      exit(1);
+    }
+    return found->second;
+  }
+
+  // Reads plan's source one item at a time and pushes each through every
+  // stage into sink(item), which returns false to stop. Reading also stops
+  // as soon as a take(n) has let its n items through.
+  template <typename SINK>
+  void run_pipeline(const PIPELINE &plan, SINK sink)
+  {
+    size_t count = plan.stages.size();
+    std::vector<FUNCTION_DECLARATION_STATEMENT *> callbacks(count, nullptr);
+    std::vector<long long> left(count, 0); // TAKE: how many more it lets through
+    for (size_t k = 0; k < count; k++)
+    {
+      CALL_EXPRESSION *call = plan.stages[k].call;
+      if (plan.stages[k].op != PIPELINE::STAGE::TAKE)
+        callbacks[k] = callback(call);
+      else
+      {
+        call->arguments[0]->accept(this);
+        left[k] = last_evaluated_value.int_val;
+        if (left[k] <= 0)
+          return; // no item would get through: the source is never read
+      }
+    }
+
+    // One source item; false once no further item is wanted
+    auto feed = [&](RuntimeValue item)
+    {
+      bool more = true;
+      for (size_t k = 0; k < count; k++)
+      {
+        switch (plan.stages[k].op)
+        {
+        case PIPELINE::STAGE::MAP:
+          invoke(callbacks[k], &item);
+          item = std::move(last_evaluated_value);
+          break;
+        case PIPELINE::STAGE::FILTER:
+        {
+          RuntimeValue argument = shared_copy(item);
+          invoke(callbacks[k], &argument);
+          if (!last_evaluated_value.bool_val)
+            return more;
+          break;
+        }
+        case PIPELINE::STAGE::TAKE:
+          if (--left[k] == 0)
+            more = false;
+          break;
+        }
+      }
+      return sink(std::move(item)) && more;
+    };
+
+    switch (plan.source)
+    {
+    case PIPELINE::RANGE:
+    {
+      for_each_in_range(plan.origin, [&](long long i) { return feed(RuntimeValue::Integer(i)); });
+      break;
+    }
+    case PIPELINE::LINES:
+    {
+      LINE_READER &reader = reader_for(plan.origin);
+      std::string line;
+      while (reader.read_line(line))
+        if (!feed(RuntimeValue::String(line)))
+          break;
+      break;
+    }
+    case PIPELINE::ARRAY:
+    {
+      static_cast<GET_EXPRESSION *>(plan.origin->callee)->object_expression->accept(this);
+      RuntimeValue items = std::move(last_evaluated_value); // a snapshot, as in foreach
+      for (size_t i = 0, length = items.array_length(); i < length; i++)
+        if (!feed(items.array_get(i)))
+          break;
+      break;
+    }
+    }
+  }
+
+  // collect() or reduce(f, initial), the end of expr->pipeline
+  void finish_pipeline(CALL_EXPRESSION *expr)
+  {
+    const PIPELINE &plan = *expr->pipeline;
+    if (static_cast<GET_EXPRESSION *>(expr->callee)->member_name.VALUE == "collect")
+    {
+      RuntimeValue result = RuntimeValue::TypedArray(RuntimeValue::storage_for(plan.item_type));
+      run_pipeline(plan, [&](RuntimeValue &&item)
+                   {
+                     result.array_push(item);
+                     return true; });
+      last_evaluated_value = std::move(result);
+      return;
+    }
+
+    FUNCTION_DECLARATION_STATEMENT *func = callback(expr);
+    expr->arguments[1]->accept(this);
+    RuntimeValue args[2]; // the accumulator and the next item
+    args[0] = std::move(last_evaluated_value);
+    run_pipeline(plan, [&](RuntimeValue &&item)
+                 {
+                   args[1] = std::move(item);
+                   invoke(func, args);
+                   args[0] = std::move(last_evaluated_value);
+                   return true; });
+    last_evaluated_value = std::move(args[0]);
+  }
+
+  // --- VECTORIZED LOOPS ---
+  // A VECTOR_LOOP runs VECTOR_BLOCK iterations at a time: each node of E
+  // becomes a buffer of that many ints or doubles (a[i] reads the array's
+  // own elements in place), combined with VECTOR_KERNELS. The int/float
+  // type of every node follows apply_binary: int op int stays int, any
+  // double makes the result double.
+  static constexpr size_t VECTOR_BLOCK = 256;
+
+  struct VECTOR_OPERAND
+  {
+    bool is_float = false;
+    const RuntimeValue *array = nullptr; // ELEMENT: the storage holding a's elements
+    size_t offset = 0;                   // of a[0] in that storage (views)
+    const long long *ints = nullptr;     // the current block
+    const double *floats = nullptr;
+    std::vector<long long> int_block;
+    std::vector<double> float_block, widened;
+
+    const double *as_floats(size_t count)
+    {
+      if (is_float)
+        return floats;
+      widened.resize(VECTOR_BLOCK);
+      VECTOR_KERNELS::widen(ints, widened.data(), count);
+      return widened.data();
+    }
+  };
+
+  // The storage of a plain array or view whose elements are unboxed ints or
+  // floats, and where a[0] sits in it; nullptr for anything else
+  static const RuntimeValue *numeric_elements(const RuntimeValue &v, size_t &offset)
+  {
+    if (v.type != RuntimeValue::ARRAY || v.is_grid())
+      return nullptr;
+    const RuntimeValue *storage = v.is_view() ? v.array().view_source.get() : &v;
+    offset = v.is_view() ? v.array().view_offset : 0;
+    if (storage->array().sparse || storage->is_grid() ||
+        (storage->array().array_storage != RuntimeValue::INT_ELEMENTS && storage->array().array_storage != RuntimeValue::FLOAT_ELEMENTS))
+      return nullptr;
+    return storage;
+  }
+
+  // The loop once its initializer has run. False, before anything is
+  // written, when a value does not have the shape the plan needs (or the
+  // range reaches past an array's end, where the plain loop grows or
+  // stops with an error).
+  bool run_vector_loop(FOR_STATEMENT *stmt)
+  {
+    const VECTOR_LOOP &plan = *stmt->vector_loop;
+    auto condition = static_cast<BINARY_EXPRESSION *>(stmt->condition);
+    RuntimeValue *counter = current_environment->lookup(plan.counter);
+    if (counter->type != RuntimeValue::INT)
+      return false;
+
+    long long start = counter->int_val, end;
+    EXPRESSION *limit = condition->right_operand;
+    if (limit->kind == NODE_LITERAL_EXPRESSION)
+    {
+      limit->accept(this);
+      if (last_evaluated_value.type != RuntimeValue::INT)
+        return false;
+      end = last_evaluated_value.int_val;
+    }
+    else if (limit->kind == NODE_VARIABLE_EXPRESSION)
+    {
+      const RuntimeValue *slot = current_environment->lookup(static_cast<VARIABLE_EXPRESSION *>(limit)->name.VALUE);
+      if (slot->type != RuntimeValue::INT)
+        return false;
+      end = slot->int_val;
+    }
+    else
+    {
+      auto object = static_cast<VARIABLE_EXPRESSION *>(static_cast<GET_EXPRESSION *>(limit)->object_expression);
+      const RuntimeValue *measured = current_environment->lookup(object->name.VALUE);
+      if (measured->type == RuntimeValue::ARRAY)
+        end = measured->array_length();
+      else if (measured->type == RuntimeValue::STRING)
+        end = measured->string_val.size();
+      else
+        return false;
+    }
+    if (condition->operator_token.TYPE == TOKEN_LESS_EQUAL)
+    {
+      if (end == LLONG_MAX)
+        return false;
+      end++;
+    }
+    if (start >= end)
+      return true;
+    if (start < 0)
+      return false;
+
+    // 1. Check every operand before touching anything
+    size_t offset;
+    RuntimeValue *target = current_environment->lookup(plan.target);
+    if (plan.kind == VECTOR_LOOP::MAP ? !numeric_elements(*target, offset) || (long long)target->flat_length() < end
+                                      : target->type != RuntimeValue::INT && target->type != RuntimeValue::FLOAT)
+      return false;
+
+    std::vector<VECTOR_OPERAND> operands(plan.nodes.size());
+    for (size_t k = 0; k < plan.nodes.size(); k++)
+    {
+      const VECTOR_LOOP::NODE &node = plan.nodes[k];
+      VECTOR_OPERAND &operand = operands[k];
+      switch (node.op)
+      {
+      case VECTOR_LOOP::NODE::ELEMENT:
+      {
+        const RuntimeValue *array = current_environment->lookup(node.name);
+        const RuntimeValue *storage = numeric_elements(*array, offset);
+        if (!storage || (long long)array->flat_length() < end)
+          return false;
+        operand.is_float = storage->array().array_storage == RuntimeValue::FLOAT_ELEMENTS;
+        break;
+      }
+      case VECTOR_LOOP::NODE::COUNTER:
+        operand.int_block.resize(VECTOR_BLOCK);
+        operand.ints = operand.int_block.data();
+        break;
+      case VECTOR_LOOP::NODE::VALUE:
+      {
+        const RuntimeValue *value = &last_evaluated_value;
+        if (node.value->kind == NODE_VARIABLE_EXPRESSION)
+          value = current_environment->lookup(node.name);
+        else
+          node.value->accept(this);
+        if (value->type == RuntimeValue::INT)
+        {
+          operand.int_block.assign(VECTOR_BLOCK, value->int_val);
+          operand.ints = operand.int_block.data();
+        }
+        else if (value->type == RuntimeValue::FLOAT)
+        {
+          operand.is_float = true;
+          operand.float_block.assign(VECTOR_BLOCK, value->float_val);
+          operand.floats = operand.float_block.data();
+        }
+        else
+          return false;
+        break;
+      }
+      default:
+        operand.is_float = operands[node.left].is_float || operands[node.right].is_float;
+        if (operand.is_float)
+          operand.float_block.resize(VECTOR_BLOCK);
+        else
+          operand.int_block.resize(VECTOR_BLOCK);
+        break;
+      }
+    }
+    bool float_result = operands.back().is_float;
+    bool float_target = plan.kind == VECTOR_LOOP::MAP ? target->array().array_storage == RuntimeValue::FLOAT_ELEMENTS
+                                                      : target->type == RuntimeValue::FLOAT;
+    if (float_result && !float_target)
+      return false;
 
-      try
+    // 2. Take the elements. c gets storage of its own first, so a[i]
+    // operands that are c itself see where it now lives.
+    if (plan.kind == VECTOR_LOOP::MAP)
+      target->unshare();
+    for (size_t k = 0; k < plan.nodes.size(); k++)
+      if (plan.nodes[k].op == VECTOR_LOOP::NODE::ELEMENT)
+        operands[k].array = numeric_elements(*current_environment->lookup(plan.nodes[k].name), operands[k].offset);
+
+    // 3. Run the range block by block
+    unsigned long long int_total = (unsigned long long)target->int_val;
+    double float_total = target->float_val;
+    for (long long first = start; first < end; first += VECTOR_BLOCK)
+    {
+      size_t count = (size_t)std::min<long long>(VECTOR_BLOCK, end - first);
+      for (size_t k = 0; k < plan.nodes.size(); k++)
       {
-        stmt->body_statement->accept(this);
+        const VECTOR_LOOP::NODE &node = plan.nodes[k];
+        VECTOR_OPERAND &operand = operands[k];
+        switch (node.op)
+        {
+        case VECTOR_LOOP::NODE::ELEMENT:
+          if (operand.is_float)
+            operand.floats = operand.array->array().float_elements.data() + operand.offset + first;
+          else
+            operand.ints = operand.array->array().int_elements.data() + operand.offset + first;
+          break;
+        case VECTOR_LOOP::NODE::COUNTER:
+          for (size_t j = 0; j < count; j++)
+            operand.int_block[j] = first + (long long)j;
+          break;
+        case VECTOR_LOOP::NODE::VALUE:
+          break;
+        default:
+        {
+          auto op = node.op == VECTOR_LOOP::NODE::ADD        ? VECTOR_KERNELS::ADD
+                    : node.op == VECTOR_LOOP::NODE::SUBTRACT ? VECTOR_KERNELS::SUBTRACT
+                                                             : VECTOR_KERNELS::MULTIPLY;
+          VECTOR_OPERAND &left = operands[node.left], &right = operands[node.right];
+          if (operand.is_float)
+          {
+            VECTOR_KERNELS::apply(op, left.as_floats(count), right.as_floats(count), operand.float_block.data(), count);
+            operand.floats = operand.float_block.data();
+          }
+          else
+          {
+            VECTOR_KERNELS::apply(op, left.ints, right.ints, operand.int_block.data(), count);
+            operand.ints = operand.int_block.data();
+          }
+        }
+        }
       }
-      catch (BreakException)
+
+      VECTOR_OPERAND &result = operands.back();
+      if (plan.kind == VECTOR_LOOP::MAP)
       {
-        break;
+        if (!float_target)
+          std::memmove(target->array().int_elements.data() + first, result.ints, count * sizeof(long long));
+        else if (float_result)
+          std::memmove(target->array().float_elements.data() + first, result.floats, count * sizeof(double));
+        else
+          VECTOR_KERNELS::widen(result.ints, target->array().float_elements.data() + first, count);
       }
-      catch (ContinueException)
+      else if (!float_target)
+        int_total += (unsigned long long)VECTOR_KERNELS::sum(result.ints, count);
+      else
       {
-        continue;
+        // s = s + x one element at a time, as the loop would round it
+        const double *values = result.as_floats(count);
+        for (size_t j = 0; j < count; j++)
+          float_total += values[j];
       }
     }
+
+    if (plan.kind == VECTOR_LOOP::SUM)
+    {
+      if (float_target)
+        target->float_val = float_total;
+      else
+        target->int_val = (long long)int_total;
+    }
+    counter->int_val = end;
+    return true;
   }
 
-  // [NEW] Loop Controls
-  void visit(BREAK_STATEMENT *stmt) override { throw BreakException(); }
-  void visit(CONTINUE_STATEMENT *stmt) override { throw ContinueException(); }
+  void visit(FUNCTION_DECLARATION_STATEMENT *stmt) override { functions[stmt->name_token.VALUE] = stmt; }
 
-  // [NEW] For Statement - Dead code technically, but required for compilation
-  void visit(FOR_STATEMENT *stmt) override
+  // Read-only methods of strings and arrays (slice, and the string
+  // searches find, contains and split)
+  static bool is_value_method(const std::string &name)
   {
-    ENVIRONMENT *prev = current_environment;
-    current_environment = new ENVIRONMENT(prev); // Scope for initializer
+    return name == "slice" || name == "find" || name == "contains" || name == "split";
+  }
 
-    // 1. Run Initializer
-    if (stmt->initializer)
-      stmt->initializer->accept(this);
+  void call_value_method(RuntimeValue &receiver, const std::string &method_name, CALL_EXPRESSION *expr)
+  {
+    std::vector<RuntimeValue> args;
+    for (auto arg : expr->arguments)
+    {
+      arg->accept(this);
+      args.push_back(std::move(last_evaluated_value));
+    }
 
-    while (true)
+    if (method_name == "slice")
     {
-      // 2. Check Condition
-      if (stmt->condition)
+      bool is_string = receiver.type == RuntimeValue::STRING;
+      long long length = is_string ? receiver.string_val.size() : receiver.array_length();
+      long long start = args[0].int_val, end = args[1].int_val;
+      if (start < 0 || end < start || end > length)
       {
-        stmt->condition->accept(this);
-        if (!is_truthy(last_evaluated_value))
-          break;
+        std::cerr << "Runtime Error: slice(" << start << ", " << end << ") is out of range for length " << length << "." << std::endl;
+        exit(1);
       }
-
-      // 3. Run Body
-      try
+      if (is_string)
+        last_evaluated_value = RuntimeValue::String(receiver.string_val.substr(start, end - start));
+      else if (in_parallel_worker && !receiver.is_view() && !receiver.is_grid())
       {
-        stmt->body->accept(this);
+        RuntimeValue copy = receiver; // see shared_copy
+        last_evaluated_value = copy.slice(start, end);
       }
-      catch (const BreakException &)
+      else
+        last_evaluated_value = receiver.slice(start, end);
+      return;
+    }
+
+    std::string_view text = receiver.string_val;
+    std::string_view needle = args[0].string_val;
+    if (method_name == "find")
+    {
+      long long from = args.size() > 1 ? args[1].int_val : 0;
+      if (from < 0)
       {
-        break; // Stop loop entirely
+        std::cerr << "Runtime Error: find() start cannot be negative." << std::endl;
+        exit(1);
       }
-      catch (const ContinueException &)
+      size_t at = TEXT_SEARCH::find(text, needle, from);
+      last_evaluated_value = RuntimeValue::Integer(at == TEXT_SEARCH::NOT_FOUND ? -1 : (long long)at);
+    }
+    else if (method_name == "contains")
+      last_evaluated_value = RuntimeValue::Bool(TEXT_SEARCH::find(text, needle) != TEXT_SEARCH::NOT_FOUND);
+    else
+    {
+      if (needle.empty())
       {
-        // Catch it, but DO NOTHING.
-        // Just let execution fall through to step 4 (Increment).
+        std::cerr << "Runtime Error: split() separator cannot be empty." << std::endl;
+        exit(1);
       }
+      std::vector<RuntimeValue> parts;
+      for (std::string_view part : TEXT_SEARCH::split(text, needle))
+        parts.push_back(RuntimeValue::String(part));
+      last_evaluated_value = RuntimeValue::Array(std::move(parts));
+    }
+  }
 
-      // 4. Run Increment (This runs even after continue!)
-      if (stmt->increment)
-        stmt->increment->accept(this);
+  // Methods of map<K, V>:
+  //   m.size()              -> int
+  //   m.contains(k)         -> bool
+  //   m.get(k[, fallback])  -> V, fallback (or an error) when k is absent
+  //   m.remove(k)           -> bool, whether k was there
+  //   m.keys(), m.values()  -> K[], V[] in insertion order
+  // remove() is given the map's location ('target') when it has one, so
+  // it changes the stored map rather than a copy
+  void call_map_method(RuntimeValue *map, const std::string &method_name, CALL_EXPRESSION *expr, LOCATION *target)
+  {
+    if (method_name == "size")
+    {
+      last_evaluated_value = RuntimeValue::Integer(map->map_val->size());
+      return;
+    }
+    const RuntimeMap &entries = *map->map_val;
+    if (method_name == "values" && entries.size() == entries.entry_count())
+    {
+      last_evaluated_value = entries.values; // no dead entries to leave out
+      return;
+    }
+    if (method_name == "keys" || method_name == "values")
+    {
+      bool keys = method_name == "keys";
+      bool int_keys = keys && entries.size() > 0 && !entries.keys[0].is_text;
+      RuntimeValue list = RuntimeValue::TypedArray(keys ? (int_keys ? RuntimeValue::INT_ELEMENTS : RuntimeValue::BOXED) : entries.values.array().array_storage);
+      list.flat_resize(entries.size());
+      size_t n = 0;
+      for (size_t i = 0; i < entries.entry_count(); i++)
+        if (entries.live[i])
+          list.slot_set(n++, keys ? entries.keys[i].value() : entries.values.slot_get(i));
+      last_evaluated_value = std::move(list);
+      return;
     }
 
-    current_environment = prev; // Cleanup scope
-  }
+    RuntimeMap::KEY key = evaluate_key(expr->arguments[0]);
+    if (method_name == "remove")
+    {
+      // Walked again: evaluating the key may have moved the map
+      if (target)
+        map = walk_location(*target, target->keys.size());
+      last_evaluated_value = RuntimeValue::Bool(writable_map(*map).remove(key));
+      return;
+    }
+    if (method_name == "contains")
+    {
+      last_evaluated_value = RuntimeValue::Bool(map->map_val->find(key) != HASH_INDEX::NONE);
+      return;
+    }
 
-  void visit(FUNCTION_DECLARATION_STATEMENT *stmt) override { functions[stmt->name_token.VALUE] = stmt; }
+    // get
+    if (expr->arguments.size() < 2)
+    {
+      last_evaluated_value = map_get(*map, key);
+      return;
+    }
+    expr->arguments[1]->accept(this); // the fallback, kept when key is absent
+    uint32_t entry = map->map_val->find(key);
+    if (entry != HASH_INDEX::NONE)
+      last_evaluated_value = map->map_val->values.array_get(entry);
+  }
 
   void visit(CALL_EXPRESSION *expr) override
   {
-    if (auto get_expr = dynamic_cast<GET_EXPRESSION *>(expr->callee))
+    // Only the end of a pipeline is ever evaluated; it runs the whole chain
+    if (expr->pipeline)
     {
-      get_expr->object_expression->accept(this);
-      RuntimeValue obj_val = last_evaluated_value;
-      
+      finish_pipeline(expr);
+      return;
+    }
+    if (expr->target == CALL_EXPRESSION::CALL_METHOD)
+    {
+      auto get_expr = static_cast<GET_EXPRESSION *>(expr->callee);
+
+      // The receiver is used where it is stored: a slice shares its
+      // elements, push() appends to the array itself and remove() takes
+      // the key out of the map itself. Their target is resolved like an
+      // assignment target, so a[i].push(v) and m[k].remove(j) work too.
+      const std::string &member = get_expr->member_name.VALUE;
+      bool pushes = (member == "push" || member == "remove") && is_assignable(get_expr->object_expression);
+      LOCATION push_target;
+      RuntimeValue receiver_scratch;
+      RuntimeValue *receiver;
+      if (pushes)
+      {
+        push_target = resolve_location(get_expr->object_expression);
+        receiver = walk_location(push_target, push_target.keys.size());
+      }
+      else
+        receiver = borrow(get_expr->object_expression, receiver_scratch);
+
       bool is_super = is_super_call_flag;
       is_super_call_flag = false;
 
-      if (obj_val.type == RuntimeValue::ARRAY)
+      if (receiver->type == RuntimeValue::MAP)
+      {
+        call_map_method(receiver, member, expr, pushes ? &push_target : nullptr);
+        return;
+      }
+
+      if ((receiver->type == RuntimeValue::ARRAY || receiver->type == RuntimeValue::STRING) && is_value_method(get_expr->member_name.VALUE))
+      {
+        call_value_method(*receiver, get_expr->member_name.VALUE, expr);
+        return;
+      }
+
+      if (receiver->type == RuntimeValue::ARRAY && get_expr->member_name.VALUE == "push")
       {
-          std::string method_name = get_expr->member_name.VALUE;
-          if (method_name == "push")
+          if (!pushes)
           {
-              if (expr->arguments.size() != 1)
-              {
-                  std::cerr << "Runtime Error: push() expects exactly 1 argument." << std::endl;
-                  exit(1);
-              }
-              expr->arguments[0]->accept(this);
-              RuntimeValue arg_val = last_evaluated_value;
-              
-              // Push to the local copy of the array
-              obj_val.array_elements.push_back(arg_val);
-              
-              // Propagate the updated array back up to the environment, object, or parent array
-              update_value_in_environment(get_expr->object_expression, obj_val);
-              
-              last_evaluated_value = obj_val;
-              return;
+              std::cerr << "Runtime Error: Invalid assignment target." << std::endl;
+              exit(1);
+          }
+          if (expr->arguments.size() != 1)
+          {
+              std::cerr << "Runtime Error: push() expects exactly 1 argument." << std::endl;
+              exit(1);
           }
+          expr->arguments[0]->accept(this);
+          // Walked again: evaluating the argument may have resized arrays
+          walk_location(push_target, push_target.keys.size())->array_push(last_evaluated_value);
+          last_evaluated_value = RuntimeValue::Void();
+          return;
       }
 
+      RuntimeValue obj_val = *receiver;
       if (obj_val.type != RuntimeValue::OBJECT || obj_val.object_val == nullptr)
       {
         std::cerr << "Runtime Error: Cannot call method on non-object." << std::endl;
@@ -713,7 +3573,7 @@ public:
       for (auto arg : expr->arguments)
       {
         arg->accept(this);
-        args.push_back(last_evaluated_value);
+        args.push_back(std::move(last_evaluated_value));
       }
 
       ENVIRONMENT *prev = current_environment;
@@ -722,7 +3582,7 @@ public:
 
       for (size_t i = 0; i < method_stmt->parameters.size(); i++)
       {
-        current_environment->define(method_stmt->parameters[i].name_token.VALUE, args[i]);
+        current_environment->define(method_stmt->parameters[i].name_token.VALUE, std::move(args[i]));
       }
 
       try
@@ -730,17 +3590,18 @@ public:
         method_stmt->body_block->accept(this);
         last_evaluated_value = RuntimeValue::Void();
       }
-      catch (const ReturnException &ret)
+      catch (ReturnException &ret)
       {
-        last_evaluated_value = ret.value;
+        last_evaluated_value = std::move(ret.value);
       }
 
       ENVIRONMENT *temp = current_environment;
       current_environment = prev;
       delete temp;
     }
-    else if (auto super_expr = dynamic_cast<SUPER_EXPRESSION *>(expr->callee))
+    else if (expr->target == CALL_EXPRESSION::CALL_SUPER)
     {
+        auto super_expr = static_cast<SUPER_EXPRESSION *>(expr->callee);
         super_expr->accept(this);
         RuntimeValue obj_val = last_evaluated_value;
         is_super_call_flag = false;
@@ -756,7 +3617,7 @@ public:
             for (auto arg : expr->arguments)
             {
                 arg->accept(this);
-                args.push_back(last_evaluated_value);
+                args.push_back(std::move(last_evaluated_value));
             }
             
             ENVIRONMENT *prev = current_environment;
@@ -765,7 +3626,7 @@ public:
             
             for (size_t i = 0; i < method_stmt->parameters.size(); i++)
             {
-                current_environment->define(method_stmt->parameters[i].name_token.VALUE, args[i]);
+                current_environment->define(method_stmt->parameters[i].name_token.VALUE, std::move(args[i]));
             }
             
             try
@@ -782,8 +3643,9 @@ public:
         }
         last_evaluated_value = RuntimeValue::Void();
     }
-    else if (auto var_expr = dynamic_cast<VARIABLE_EXPRESSION *>(expr->callee))
+    else if (expr->target == CALL_EXPRESSION::CALL_FUNCTION)
     {
+      auto var_expr = static_cast<VARIABLE_EXPRESSION *>(expr->callee);
       std::string name = var_expr->name.VALUE;
 
       if (name == "int" || name == "float" || name == "string") {
@@ -792,23 +3654,57 @@ public:
           
           if (name == "int") {
               if (val.type == RuntimeValue::FLOAT) last_evaluated_value = RuntimeValue::Integer(val.float_val);
-              else if (val.type == RuntimeValue::STRING) last_evaluated_value = RuntimeValue::Integer(std::stoll(val.string_val));
+              else if (val.type == RuntimeValue::STRING) last_evaluated_value = RuntimeValue::Integer(std::stoll(val.string_val.str()));
               else if (val.type == RuntimeValue::BOOL) last_evaluated_value = RuntimeValue::Integer(val.bool_val ? 1 : 0);
               else last_evaluated_value = RuntimeValue::Integer(val.int_val);
           } else if (name == "float") {
               if (val.type == RuntimeValue::INT) last_evaluated_value = RuntimeValue::Float(val.int_val);
-              else if (val.type == RuntimeValue::STRING) last_evaluated_value = RuntimeValue::Float(std::stod(val.string_val));
+              else if (val.type == RuntimeValue::STRING) last_evaluated_value = RuntimeValue::Float(std::stod(val.string_val.str()));
               else if (val.type == RuntimeValue::BOOL) last_evaluated_value = RuntimeValue::Float(val.bool_val ? 1.0 : 0.0);
               else last_evaluated_value = RuntimeValue::Float(val.float_val);
           } else if (name == "string") {
-              if (val.type == RuntimeValue::INT) last_evaluated_value = RuntimeValue::String(std::to_string(val.int_val));
-              else if (val.type == RuntimeValue::FLOAT) last_evaluated_value = RuntimeValue::String(std::to_string(val.float_val));
+              if (val.type == RuntimeValue::INT) last_evaluated_value = RuntimeValue::String(NUMBER_FORMATTER::to_string(val.int_val));
+              else if (val.type == RuntimeValue::FLOAT) last_evaluated_value = RuntimeValue::String(NUMBER_FORMATTER::to_string(val.float_val));
               else if (val.type == RuntimeValue::BOOL) last_evaluated_value = RuntimeValue::String(val.bool_val ? "true" : "false");
               else last_evaluated_value = RuntimeValue::String(val.string_val);
           }
           return;
       }
 
+      // read_line() / read_line(path): next line as a string, "" at the end
+      if (name == "read_line" && !functions.count(name)) {
+          std::string line;
+          reader_for(expr).read_line(line);
+          last_evaluated_value = RuntimeValue::String(line);
+          return;
+      }
+
+      // end_of_input() / end_of_input(path): true once no line is left
+      if (name == "end_of_input" && !functions.count(name)) {
+          last_evaluated_value = RuntimeValue::Bool(reader_for(expr).at_end());
+          return;
+      }
+
+      // Bulk numeric loading: read_ints(path?), read_floats(path?),
+      // read_int_column(path, column), read_float_column(path, column)
+      if ((name == "read_ints" || name == "read_int_column") && !functions.count(name)) {
+          last_evaluated_value = load_numbers<long long>(expr, name);
+          return;
+      }
+      if ((name == "read_floats" || name == "read_float_column") && !functions.count(name)) {
+          last_evaluated_value = load_numbers<double>(expr, name);
+          return;
+      }
+
+      if ((name == "sum" || name == "min" || name == "max" || name == "dot") && !functions.count(name)) {
+          last_evaluated_value = reduce_array(name, expr);
+          return;
+      }
+      if ((name == "matrix" || name == "transpose" || name == "matmul") && !functions.count(name)) {
+          last_evaluated_value = matrix_builtin(name, expr);
+          return;
+      }
+
       if (structs.count(name))
       {
         auto &str_def = structs[name];
@@ -816,13 +3712,13 @@ public:
         for (auto arg : expr->arguments)
         {
           arg->accept(this);
-          args.push_back(last_evaluated_value);
+          args.push_back(std::move(last_evaluated_value));
         }
 
         auto struct_obj = std::make_shared<RuntimeStruct>(name);
         for (size_t i = 0; i < str_def.fields.size(); i++)
         {
-          struct_obj->fields[str_def.fields[i]->name_token.VALUE] = args[i];
+          struct_obj->fields[str_def.fields[i]->name_token.VALUE] = std::move(args[i]);
         }
 
         RuntimeValue val;
@@ -837,24 +3733,9 @@ public:
         for (auto arg : expr->arguments)
         {
           arg->accept(this);
-          args.push_back(last_evaluated_value);
-        }
-        ENVIRONMENT *prev = current_environment;
-        current_environment = new ENVIRONMENT(global_environment);
-        for (size_t i = 0; i < func->parameters.size(); i++)
-          current_environment->define(func->parameters[i].name_token.VALUE, args[i]);
-        try
-        {
-          func->body_block->accept(this);
-          last_evaluated_value = RuntimeValue::Void();
-        }
-        catch (const ReturnException &ret)
-        {
-          last_evaluated_value = ret.value;
+          args.push_back(std::move(last_evaluated_value));
         }
-        ENVIRONMENT *temp = current_environment;
-        current_environment = prev;
-        delete temp;
+        invoke(func, args.data());
       }
       else
       {
@@ -869,15 +3750,37 @@ public:
     }
   }
 
+  // Runs a user function on args (one per parameter, moved from) in a
+  // fresh environment; its result is left in last_evaluated_value
+  void invoke(FUNCTION_DECLARATION_STATEMENT *func, RuntimeValue *args)
+  {
+    ENVIRONMENT *prev = current_environment;
+    current_environment = new ENVIRONMENT(global_environment);
+    for (size_t i = 0; i < func->parameters.size(); i++)
+      current_environment->define(func->parameters[i].name_token.VALUE, std::move(args[i]));
+    try
+    {
+      func->body_block->accept(this);
+      last_evaluated_value = RuntimeValue::Void();
+    }
+    catch (ReturnException &ret)
+    {
+      last_evaluated_value = std::move(ret.value);
+    }
+    ENVIRONMENT *temp = current_environment;
+    current_environment = prev;
+    delete temp;
+  }
+
   void visit(RETURN_STATEMENT *stmt) override
   {
     RuntimeValue val = RuntimeValue::Void();
     if (stmt->value_expression)
     {
       stmt->value_expression->accept(this);
-      val = last_evaluated_value;
+      val = std::move(last_evaluated_value);
     }
-    throw ReturnException{val};
+    throw ReturnException{std::move(val)};
   }
 
   // [MODIFIED] Logic for Auto-Conversion
@@ -889,37 +3792,33 @@ public:
       std::cout << last_evaluated_value.string_val;
     }
     std::string line;
-    std::getline(std::cin, line);
+    stdin_reader.read_line(line);
+
+    // Auto-Conversion Logic (no exceptions: std::from_chars reports failure)
+    // Leading whitespace and a '+' sign are accepted, as std::stoll/stod did
+    const char *first = line.data();
+    const char *last = first + line.size();
+    while (first < last && std::isspace((unsigned char)*first))
+      first++;
+    if (last - first > 1 && *first == '+' && first[1] != '-' && first[1] != '+')
+      first++;
 
-    // Auto-Conversion Logic
     // Try Int
-    try
-    {
-      size_t idx;
-      long long i = std::stoll(line, &idx);
-      if (idx == line.length())
-      { // Successfully parsed whole string
-        last_evaluated_value = RuntimeValue::Integer(i);
-        return;
-      }
-    }
-    catch (...)
+    long long i = 0;
+    auto int_result = std::from_chars(first, last, i);
+    if (first < last && int_result.ec == std::errc() && int_result.ptr == last)
     {
+      last_evaluated_value = RuntimeValue::Integer(i);
+      return;
     }
 
     // Try Float
-    try
-    {
-      size_t idx;
-      double d = std::stod(line, &idx);
-      if (idx == line.length())
-      {
-        last_evaluated_value = RuntimeValue::Float(d);
-        return;
-      }
-    }
-    catch (...)
+    double d = 0;
+    auto float_result = std::from_chars(first, last, d);
+    if (first < last && float_result.ec == std::errc() && float_result.ptr == last)
     {
+      last_evaluated_value = RuntimeValue::Float(d);
+      return;
     }
 
     // Fallback to String
@@ -928,44 +3827,211 @@ public:
 
   void visit(ARRAY_LITERAL_EXPRESSION *expr) override
   {
-    std::vector<RuntimeValue> elements;
-    for (auto el : expr->elements)
+    RuntimeValue array = RuntimeValue::TypedArray(RuntimeValue::storage_for(expr->element_type));
+    array.array_resize(expr->elements.size());
+    for (size_t i = 0; i < expr->elements.size(); i++)
     {
-      el->accept(this);
-      elements.push_back(last_evaluated_value);
+      expr->elements[i]->accept(this);
+      array.array_set(i, last_evaluated_value);
     }
-    last_evaluated_value = RuntimeValue::Array(elements);
+    array.try_make_grid(); // [[1, 2], [3, 4]]
+    last_evaluated_value = std::move(array);
   }
 
-  void visit(ARRAY_ACCESS_EXPRESSION *expr) override
+  // The value of an expression, read without copying it: a variable, or a
+  // field reached from one (o.f, o.p.q), is used in place; anything else is
+  // evaluated into 'scratch'. A borrowed field's object is held in
+  // 'scratch' too, so the field stays valid even if evaluating something
+  // else meanwhile reassigns the variable that led to it.
+  RuntimeValue *borrow(EXPRESSION *expr, RuntimeValue &scratch)
   {
-    expr->array_expression->accept(this);
-    RuntimeValue arr = last_evaluated_value;
-    expr->index_expression->accept(this);
-    RuntimeValue idx = last_evaluated_value;
-    if (arr.type != RuntimeValue::ARRAY)
+    if (expr->kind == NODE_VARIABLE_EXPRESSION)
+      return current_environment->lookup(static_cast<VARIABLE_EXPRESSION *>(expr)->name.VALUE);
+    if (expr->kind == NODE_GET_EXPRESSION)
     {
-      std::cerr << "Not an array." << std::endl;
+      auto get_expr = static_cast<GET_EXPRESSION *>(expr);
+      RuntimeValue owner;
+      RuntimeValue *object = borrow(get_expr->object_expression, owner);
+      if (RuntimeValue *field = find_field(*object, get_expr->member_name.VALUE))
+      {
+        scratch = object == &owner ? std::move(owner) : *object;
+        return field;
+      }
+      read_member(*object, get_expr);
+    }
+    else
+      expr->accept(this);
+    scratch = std::move(last_evaluated_value);
+    return &scratch;
+  }
+
+  // Storage of a field of an object or struct, nullptr if there is none
+  RuntimeValue *find_field(const RuntimeValue &object, const std::string &member)
+  {
+    std::unordered_map<std::string, RuntimeValue> *fields = nullptr;
+    if (object.type == RuntimeValue::OBJECT && object.object_val != nullptr)
+      fields = &object.object_val->fields;
+    else if (object.type == RuntimeValue::STRUCT && object.struct_val != nullptr)
+      fields = &object.struct_val->fields;
+    if (!fields)
+      return nullptr;
+    auto found = fields->find(member);
+    return found == fields->end() ? nullptr : &found->second;
+  }
+
+  // s[i]: the character at i, as a one-character string
+  RuntimeValue string_char(const RuntimeValue &text, long long idx)
+  {
+    if (idx < 0 || idx >= (long long)text.string_val.size())
+    {
+      std::cerr << "Index out of bounds." << std::endl;
       exit(1);
     }
-    if (idx.type != RuntimeValue::INT)
+    return RuntimeValue::String(text.string_val.substr(idx, 1));
+  }
+
+  long long index_of(const RuntimeValue &index)
+  {
+    if (index.type != RuntimeValue::INT)
     {
       std::cerr << "Index not int." << std::endl;
       exit(1);
     }
-    if (idx.int_val < 0 || idx.int_val >= arr.array_elements.size())
+    return index.int_val;
+  }
+
+  long long evaluate_index(EXPRESSION *index_expression)
+  {
+    index_expression->accept(this);
+    return index_of(last_evaluated_value);
+  }
+
+  void visit(ARRAY_ACCESS_EXPRESSION *expr) override
+  {
+    // a[i][j]: one offset into a grid, or the element of a boxed row read
+    // in place; neither copies a row
+    if (expr->array_expression->kind == NODE_ARRAY_ACCESS_EXPRESSION)
     {
-      std::cerr << "Index out of bounds." << std::endl;
-      exit(1);
+      auto row_access = static_cast<ARRAY_ACCESS_EXPRESSION *>(expr->array_expression);
+      RuntimeValue base_copy;
+      const RuntimeValue *base = borrow(row_access->array_expression, base_copy);
+      if (base->type == RuntimeValue::MAP)
+      {
+        // m[k][j]: the entry is looked up once both keys are known
+        RuntimeMap::KEY key = evaluate_key(row_access->index_expression);
+        expr->index_expression->accept(this);
+        RuntimeValue column = std::move(last_evaluated_value);
+        const RuntimeValue *row = map_element(*base, key);
+        if (!row)
+        {
+          std::cerr << "Not an array." << std::endl;
+          exit(1);
+        }
+        if (row->type == RuntimeValue::MAP)
+          last_evaluated_value = map_get(*row, location_key(column));
+        else if (row->type == RuntimeValue::STRING)
+          last_evaluated_value = string_char(*row, index_of(column));
+        else
+        {
+          long long j = index_of(column);
+          check_element(*row, j);
+          last_evaluated_value = row->array_get(j);
+        }
+        return;
+      }
+      long long i = evaluate_index(row_access->index_expression);
+      expr->index_expression->accept(this);
+      RuntimeValue column = std::move(last_evaluated_value);
+      if (base->type == RuntimeValue::STRING)
+      {
+        last_evaluated_value = string_char(string_char(*base, i), index_of(column));
+        return;
+      }
+      if (base->type == RuntimeValue::ARRAY && base->is_grid())
+      {
+        long long j = index_of(column);
+        check_cell(*base, i, j);
+        last_evaluated_value = base->grid_get(i, j);
+        return;
+      }
+      if (!(row_access->in_bounds && base->type == RuntimeValue::ARRAY))
+        check_element(*base, i);
+      if (base->array().array_storage != RuntimeValue::BOXED)
+      {
+        std::cerr << "Not an array." << std::endl;
+        exit(1);
+      }
+      const RuntimeValue *row = base->element_slot(i);
+      if (!row)
+      {
+        std::cerr << "Not an array." << std::endl;
+        exit(1);
+      }
+      if (row->type == RuntimeValue::MAP)
+      {
+        last_evaluated_value = map_get(*row, location_key(column));
+        return;
+      }
+      if (row->type == RuntimeValue::STRING)
+      {
+        last_evaluated_value = string_char(*row, index_of(column));
+        return;
+      }
+      long long j = index_of(column);
+      check_element(*row, j);
+      last_evaluated_value = row->array_get(j);
+      return;
+    }
+
+    // v[i] proven in bounds by RANGE_ANALYSIS: no index checks
+    if (expr->in_bounds)
+    {
+      const RuntimeValue *arr = current_environment->lookup(static_cast<VARIABLE_EXPRESSION *>(expr->array_expression)->name.VALUE);
+      if (arr->type == RuntimeValue::ARRAY)
+      {
+        last_evaluated_value = arr->array_get(current_environment->lookup(static_cast<VARIABLE_EXPRESSION *>(expr->index_expression)->name.VALUE)->int_val);
+        return;
+      }
+    }
+
+    // Index a variable's (or a field's) array in place instead of copying it
+    RuntimeValue arr_copy;
+    const RuntimeValue *arr = borrow(expr->array_expression, arr_copy);
+    if (arr->type == RuntimeValue::MAP)
+    {
+      RuntimeMap::KEY key = evaluate_key(expr->index_expression);
+      last_evaluated_value = map_get(*arr, key);
+      return;
+    }
+    long long idx = evaluate_index(expr->index_expression);
+    if (arr->type == RuntimeValue::STRING)
+    {
+      last_evaluated_value = string_char(*arr, idx);
+      return;
     }
-    last_evaluated_value = arr.array_elements[idx.int_val];
+    check_element(*arr, idx);
+    last_evaluated_value = arr->array_get(idx);
   }
 
+
   void visit(ARRAY_ASSIGNMENT_EXPRESSION *expr) override
   {
-    // 1. Evaluate Array (target)
-    expr->array_expression->accept(this);
-    RuntimeValue arr_val = last_evaluated_value; // This is a COPY of the struct
+    // v[i] = x proven in bounds by RANGE_ANALYSIS: no index checks, no growth
+    if (expr->in_bounds)
+    {
+      RuntimeValue *array = current_environment->lookup(static_cast<VARIABLE_EXPRESSION *>(expr->array_expression)->name.VALUE);
+      if (array->type == RuntimeValue::ARRAY)
+      {
+        long long idx = current_environment->lookup(static_cast<VARIABLE_EXPRESSION *>(expr->index_expression)->name.VALUE)->int_val;
+        expr->value_expression->accept(this);
+        check_parallel_store(array, last_evaluated_value);
+        array->array_set(idx, RuntimeValue::copy_value(last_evaluated_value));
+        return;
+      }
+    }
+
+    // 1. Resolve Array (target) to its storage: variable, field or element
+    LOCATION loc = resolve_location(expr->array_expression);
 
     // 2. Evaluate Index
     expr->index_expression->accept(this);
@@ -975,28 +4041,22 @@ public:
     expr->value_expression->accept(this);
     RuntimeValue assign_val = last_evaluated_value;
 
-    // 4. Perform Update
-    if (idx_val.int_val < 0)
-    {
-      std::cerr << "Runtime Error: Array index cannot be negative." << std::endl;
-      exit(1);
-    }
-    
-    // Automatically expand array if index is out of bounds
-    if (idx_val.int_val >= arr_val.array_elements.size())
-    {
-        arr_val.array_elements.resize(idx_val.int_val + 1, RuntimeValue::Void());
-    }
-
-    // Update the element in our local copy
-    arr_val.array_elements[idx_val.int_val] = assign_val;
-
-    // Propagate the modified array back to the environment, object, or parent array
-    update_value_in_environment(expr->array_expression, arr_val);
+    // 4. Perform Update in place (re-walked: step 3 may have resized arrays),
+    // automatically expanding the array if the index is out of bounds, or
+    // adding the key to a map
+    loc.keys.push_back(location_key(idx_val));
+    write_location(loc, assign_val, true);
 
     last_evaluated_value = assign_val;
   }
-  void visit(EXPRESSION_STATEMENT *stmt) override { stmt->expression->accept(this); }
+  void visit(EXPRESSION_STATEMENT *stmt) override
+  {
+    stmt->expression->accept(this);
+    // Drop the unused value's share of an array, map or string buffer
+    if (last_evaluated_value.type == RuntimeValue::ARRAY || last_evaluated_value.type == RuntimeValue::MAP ||
+        last_evaluated_value.type == RuntimeValue::STRING)
+      last_evaluated_value = RuntimeValue::Void();
+  }
   // CORRECTED: Real Logic for && and ||
   void visit(LOGICAL_EXPRESSION *expr) override
   {
@@ -1039,6 +4099,8 @@ public:
         last_evaluated_value.int_val *= -1;
       else if (last_evaluated_value.type == RuntimeValue::FLOAT)
         last_evaluated_value.float_val *= -1.0;
+      else if (last_evaluated_value.type == RuntimeValue::ARRAY)
+        last_evaluated_value = apply_elementwise(TOKEN_MINUS, RuntimeValue::Integer(0), last_evaluated_value);
     }
     else if (expr->operator_token.TYPE == TOKEN_NOT)
     {
@@ -1130,6 +4192,8 @@ public:
         default_val = RuntimeValue::String("");
       else if (type == "bool")
         default_val = RuntimeValue::Bool(false);
+      else if (is_map_type(type))
+        default_val = empty_map(type);
       
       obj->fields[field_stmt->name_token.VALUE] = default_val;
     }
@@ -1163,14 +4227,14 @@ public:
       for (auto arg : expr->arguments)
       {
         arg->accept(this);
-        args.push_back(last_evaluated_value);
+        args.push_back(std::move(last_evaluated_value));
       }
 
       ENVIRONMENT *ctor_env = new ENVIRONMENT(global_environment);
       ctor_env->define("this", self_val);
       for (size_t i = 0; i < init_method->parameters.size(); ++i)
       {
-        ctor_env->define(init_method->parameters[i].name_token.VALUE, args[i]);
+        ctor_env->define(init_method->parameters[i].name_token.VALUE, std::move(args[i]));
       }
 
       ENVIRONMENT *prev = current_environment;
@@ -1191,9 +4255,15 @@ public:
 
   void visit(GET_EXPRESSION *expr) override
   {
-    expr->object_expression->accept(this);
-    RuntimeValue obj_val = last_evaluated_value;
+    // o.f copies only the field (sharing its array), never the object
+    RuntimeValue scratch;
+    RuntimeValue *value = borrow(expr, scratch);
+    last_evaluated_value = value == &scratch ? std::move(scratch) : shared_copy(*value);
+  }
 
+  // Sets last_evaluated_value to member expr->member_name of obj_val
+  void read_member(const RuntimeValue &obj_val, GET_EXPRESSION *expr)
+  {
     if (obj_val.type == RuntimeValue::OBJECT && obj_val.object_val != nullptr)
     {
       std::string member = expr->member_name.VALUE;
@@ -1232,7 +4302,7 @@ public:
     {
       std::string member = expr->member_name.VALUE;
       if (member == "length") {
-        last_evaluated_value = RuntimeValue::Integer(obj_val.array_elements.size());
+        last_evaluated_value = RuntimeValue::Integer(obj_val.array_length());
       } else {
         std::cerr << "Runtime Error: Field '" << member << "' not found on array." << std::endl;
         exit(1);
@@ -0,0 +1,110 @@
+#ifndef __LINE_READER_H
+#define __LINE_READER_H
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <cstring>
+#include <cerrno>
+#include <fcntl.h>
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+// Streams lines from a file descriptor (stdin or an opened file) through one
+// large reusable buffer. Backs input(), read_line() and end_of_input().
+// Lines are returned without their trailing '\n', like std::getline.
+class LINE_READER
+{
+public:
+  static constexpr size_t BUFFER_SIZE = 1 << 20;
+
+  // fd 0 shares its buffer between input() and read_line(); std::cout is
+  // flushed first whenever a read would block (see OUTPUT_WRITER::install)
+  LINE_READER(int descriptor, bool owns) : fd(descriptor), owns_fd(owns), buffer(BUFFER_SIZE) {}
+
+  ~LINE_READER()
+  {
+    if (owns_fd)
+      close(fd);
+  }
+
+  // nullptr if the file cannot be opened
+  static LINE_READER *open_file(const std::string &path)
+  {
+    int descriptor = open(path.c_str(), O_RDONLY);
+    if (descriptor < 0)
+      return nullptr;
+    return new LINE_READER(descriptor, true);
+  }
+
+  // Reads the next line into 'line'. False once the input is exhausted.
+  bool read_line(std::string &line)
+  {
+    line.clear();
+    bool got_any = false;
+    while (true)
+    {
+      if (start == end && !refill())
+        return got_any;
+      got_any = true;
+      const char *begin = buffer.data() + start;
+      const char *newline = static_cast<const char *>(std::memchr(begin, '\n', end - start));
+      if (newline)
+      {
+        line.append(begin, newline - begin);
+        start += (newline - begin) + 1;
+        return true;
+      }
+      line.append(begin, end - start);
+      start = end;
+    }
+  }
+
+  // True when no further line can be read (waits for input if none is buffered)
+  bool at_end() { return start == end && !refill(); }
+
+  // Appends everything not yet read to 'out' (the bulk numeric loaders)
+  void read_rest(std::string &out)
+  {
+    while (start < end || refill())
+    {
+      out.append(buffer.data() + start, end - start);
+      start = end;
+    }
+  }
+
+private:
+  int fd;
+  bool owns_fd;
+  bool exhausted = false;
+  std::vector<char> buffer;
+  size_t start = 0; // next unread byte
+  size_t end = 0;   // one past the last buffered byte
+
+  bool refill()
+  {
+    if (exhausted)
+      return false;
+    if (fd == 0 && std::cin.tie())
+      std::cin.tie()->flush(); // show prompts before waiting on the user
+
+    long count;
+    do
+      count = read(fd, buffer.data(), (unsigned)buffer.size());
+    while (count < 0 && errno == EINTR);
+
+    if (count <= 0)
+    {
+      exhausted = true;
+      return false;
+    }
+    start = 0;
+    end = (size_t)count;
+    return true;
+  }
+};
+
+#endif
@@ -0,0 +1,92 @@
+#ifndef __MATRIX_KERNELS_H
+#define __MATRIX_KERNELS_H
+
+#include "vector_kernels.hpp"
+#include <algorithm>
+#include <cstddef>
+#include <thread>
+#include <vector>
+
+// Dense row-major matrix products and transposes behind matmul() and
+// transpose(); the matrices are grids (see RuntimeValue GRIDS).
+//
+// multiply() computes C = A * B (n x k times k x m) in tiles: a band of
+// COLUMN_TILE columns of C against DEPTH_TILE rows of B at a time, so the
+// slice of B in use stays in cache while every row of A streams past it.
+// Each row of C is built as C[i][j] += A[i][p] * B[p][j] with
+// VECTOR_KERNELS::scale_add, p ascending, so a cell gets exactly the sum
+// a plain triple loop would compute. Rows of C are split across threads
+// once the product is big enough to pay for them; each thread owns its
+// rows, so the result never depends on the thread count.
+class MATRIX_KERNELS
+{
+public:
+  static constexpr size_t COLUMN_TILE = 256;
+  static constexpr size_t DEPTH_TILE = 128;
+  static constexpr size_t ROW_TILE = 16;                  // rows of A per pass over a tile of B
+  static constexpr size_t MIN_PARALLEL_WORK = 1ULL << 20; // multiply-adds before threads are used
+
+  // c must hold n * m zeros
+  template <typename T>
+  static void multiply(const T *a, const T *b, T *c, size_t n, size_t k, size_t m)
+  {
+    size_t threads = thread_count(n, n * k * m);
+    if (threads <= 1)
+      return multiply_rows(a, b, c, 0, n, k, m);
+
+    std::vector<std::thread> workers;
+    size_t per_thread = (n + threads - 1) / threads;
+    for (size_t first = 0; first < n; first += per_thread)
+    {
+      size_t last = std::min(n, first + per_thread);
+      workers.emplace_back([=]() { multiply_rows(a, b, c, first, last, k, m); });
+    }
+    for (auto &worker : workers)
+      worker.join();
+  }
+
+  // out (m x n) = the transpose of a (n x m), copied in square tiles so
+  // both sides are read and written a cache line at a time
+  template <typename T>
+  static void transpose(const T *a, T *out, size_t n, size_t m)
+  {
+    const size_t tile = 32;
+    for (size_t ii = 0; ii < n; ii += tile)
+      for (size_t jj = 0; jj < m; jj += tile)
+        for (size_t i = ii; i < std::min(n, ii + tile); i++)
+          for (size_t j = jj; j < std::min(m, jj + tile); j++)
+            out[j * n + i] = a[i * m + j];
+  }
+
+private:
+  static size_t thread_count(size_t rows, size_t work)
+  {
+    if (work < MIN_PARALLEL_WORK)
+      return 1;
+    size_t hardware = std::max(1u, std::thread::hardware_concurrency());
+    return std::min(hardware, std::max<size_t>(1, rows / ROW_TILE));
+  }
+
+  // Rows [first, last) of C
+  template <typename T>
+  static void multiply_rows(const T *a, const T *b, T *c, size_t first, size_t last, size_t k, size_t m)
+  {
+    for (size_t jj = 0; jj < m; jj += COLUMN_TILE)
+    {
+      size_t width = std::min(COLUMN_TILE, m - jj);
+      for (size_t pp = 0; pp < k; pp += DEPTH_TILE)
+      {
+        size_t depth_end = std::min(k, pp + DEPTH_TILE);
+        for (size_t ii = first; ii < last; ii += ROW_TILE)
+          for (size_t i = ii; i < std::min(last, ii + ROW_TILE); i++)
+          {
+            T *c_row = c + i * m + jj;
+            for (size_t p = pp; p < depth_end; p++)
+              VECTOR_KERNELS::scale_add(a[i * k + p], b + p * m + jj, c_row, width);
+          }
+      }
+    }
+  }
+};
+
+#endif
@@ -0,0 +1,80 @@
+#ifndef __NUMBER_FORMAT_H
+#define __NUMBER_FORMAT_H
+
+#include <charconv>
+#include <cstring>
+#include <string>
+#include <string_view>
+
+// Number -> text conversion shared by print, string '+', the string() cast
+// and the optimizer's folded literals, so every path prints a value the same
+// way.
+//   - Integers are written two digits at a time from a lookup table.
+//   - Doubles use std::to_chars' shortest round-trip form: the fewest digits
+//     that read back (std::stod) to exactly the same value, e.g. 1.5, 0.1, 1e+20.
+// Callers pass a stack buffer of BUFFER_SIZE chars and get a view into it,
+// so no formatting step allocates.
+class NUMBER_FORMATTER
+{
+public:
+  // Fits any long long (20 chars + sign) and any shortest-form double (24)
+  static constexpr size_t BUFFER_SIZE = 32;
+
+  static std::string_view format_int(long long value, char *buffer)
+  {
+    static const char digit_pairs[] =
+        "00010203040506070809"
+        "10111213141516171819"
+        "20212223242526272829"
+        "30313233343536373839"
+        "40414243444546474849"
+        "50515253545556575859"
+        "60616263646566676869"
+        "70717273747576777879"
+        "80818283848586878889"
+        "90919293949596979899";
+
+    // Work on the magnitude as unsigned so LLONG_MIN does not overflow
+    unsigned long long magnitude = value < 0 ? 0ULL - (unsigned long long)value : (unsigned long long)value;
+    char *end = buffer + BUFFER_SIZE;
+    char *p = end;
+    while (magnitude >= 100)
+    {
+      unsigned index = (unsigned)(magnitude % 100) * 2;
+      magnitude /= 100;
+      *--p = digit_pairs[index + 1];
+      *--p = digit_pairs[index];
+    }
+    if (magnitude >= 10)
+    {
+      unsigned index = (unsigned)magnitude * 2;
+      *--p = digit_pairs[index + 1];
+      *--p = digit_pairs[index];
+    }
+    else
+      *--p = (char)('0' + magnitude);
+    if (value < 0)
+      *--p = '-';
+    return std::string_view(p, end - p);
+  }
+
+  static std::string_view format_float(double value, char *buffer)
+  {
+    auto result = std::to_chars(buffer, buffer + BUFFER_SIZE, value);
+    return std::string_view(buffer, result.ptr - buffer);
+  }
+
+  static std::string to_string(long long value)
+  {
+    char buffer[BUFFER_SIZE];
+    return std::string(format_int(value, buffer));
+  }
+
+  static std::string to_string(double value)
+  {
+    char buffer[BUFFER_SIZE];
+    return std::string(format_float(value, buffer));
+  }
+};
+
+#endif
@@ -0,0 +1,224 @@
+#ifndef __NUMERIC_LOADER_H
+#define __NUMERIC_LOADER_H
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <charconv>
+#include <cstring>
+#include <algorithm>
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+// Bulk parsing of delimited numeric text for read_ints/read_floats and the
+// CSV column built-ins. The whole input is scanned in one pass: separator
+// and token boundaries are found 16 bytes at a time with SSE2 (scalar loop
+// elsewhere) and each token is converted with std::from_chars.
+//
+// Separators are whitespace and commas. A first line that does not parse as
+// numbers is treated as a header and skipped.
+class NUMERIC_LOADER
+{
+public:
+  // Describes the first token that failed to parse; empty when all parsed
+  struct PARSE_ERROR
+  {
+    std::string token;
+    size_t line = 0;
+  };
+
+  template <typename T>
+  static bool parse_all(std::string_view text, std::vector<T> &out, PARSE_ERROR &error)
+  {
+    const char *p = text.data();
+    const char *end = p + text.size();
+    out.reserve(out.size() + text.size() / 4);
+    bool first_token = true;
+
+    while (true)
+    {
+      p = skip_separators(p, end);
+      if (p == end)
+        return true;
+      const char *token_end = find_separator(p, end);
+      T value;
+      if (!parse_number(p, token_end, value))
+      {
+        if (first_token)
+        {
+          // Header line: resume after it
+          const char *newline = static_cast<const char *>(std::memchr(p, '\n', end - p));
+          p = newline ? newline + 1 : end;
+          first_token = false;
+          continue;
+        }
+        error.token.assign(p, token_end);
+        error.line = 1 + std::count(text.data(), p, '\n');
+        return false;
+      }
+      out.push_back(value);
+      first_token = false;
+      p = token_end;
+    }
+  }
+
+  // Header name -> column index, or -1 when the first line has no such name
+  static int find_column(std::string_view text, const std::string &name)
+  {
+    std::string_view header = text.substr(0, std::min(text.find('\n'), text.size()));
+    int index = 0;
+    size_t pos = 0;
+    while (pos <= header.size())
+    {
+      size_t comma = std::min(header.find(',', pos), header.size());
+      if (trim(header.substr(pos, comma - pos)) == name)
+        return index;
+      pos = comma + 1;
+      index++;
+    }
+    return -1;
+  }
+
+  // Number of comma-separated fields on the first non-blank line; 0 when
+  // there is none
+  static size_t count_columns(std::string_view text)
+  {
+    const char *p = text.data();
+    const char *end = p + text.size();
+    while (p < end)
+    {
+      const char *line_end = static_cast<const char *>(std::memchr(p, '\n', end - p));
+      if (!line_end)
+        line_end = end;
+      if (skip_separators(p, line_end) != line_end)
+        return 1 + std::count(p, line_end, ',');
+      p = line_end + 1;
+    }
+    return 0;
+  }
+
+  // Parses column 'column' of comma-separated rows. Blank lines are skipped;
+  // a row too short for the column is an error. Without a known header, a
+  // first row whose field is not a number is skipped as one.
+  template <typename T>
+  static bool parse_column(std::string_view text, size_t column, bool has_header, std::vector<T> &out, PARSE_ERROR &error)
+  {
+    const char *p = text.data();
+    const char *end = p + text.size();
+    size_t line = 0;
+    out.reserve(out.size() + std::count(p, end, '\n') + 1);
+
+    while (p < end)
+    {
+      const char *line_end = static_cast<const char *>(std::memchr(p, '\n', end - p));
+      if (!line_end)
+        line_end = end;
+      line++;
+
+      bool blank = skip_separators(p, line_end) == line_end;
+      if (!blank && !(line == 1 && has_header))
+      {
+        // Walk to the requested field; a missing field parses as empty
+        const char *field = p;
+        for (size_t index = 0; field && index < column; index++)
+        {
+          const char *comma = static_cast<const char *>(std::memchr(field, ',', line_end - field));
+          field = comma ? comma + 1 : nullptr;
+        }
+        std::string_view token;
+        if (field)
+        {
+          const char *field_end = static_cast<const char *>(std::memchr(field, ',', line_end - field));
+          token = trim(std::string_view(field, (field_end ? field_end : line_end) - field));
+        }
+        T value;
+        if (!parse_number(token.data(), token.data() + token.size(), value))
+        {
+          // An unnamed header row: first line whose field is not a number
+          if (line == 1)
+          {
+            p = line_end + 1;
+            continue;
+          }
+          error.token = std::string(token);
+          error.line = line;
+          return false;
+        }
+        out.push_back(value);
+      }
+      p = line_end + 1;
+    }
+    return true;
+  }
+
+private:
+  template <typename T>
+  static bool parse_number(const char *first, const char *last, T &value)
+  {
+    if (first < last && *first == '+' && last - first > 1 && first[1] != '-')
+      first++; // from_chars does not take an explicit '+'
+    if (first == last)
+      return false;
+    auto result = std::from_chars(first, last, value);
+    return result.ec == std::errc() && result.ptr == last;
+  }
+
+  static bool is_separator(char c) { return c == ' ' || c == ',' || c == '\n' || c == '\r' || c == '\t'; }
+
+  static std::string_view trim(std::string_view s)
+  {
+    while (!s.empty() && is_separator(s.front()))
+      s.remove_prefix(1);
+    while (!s.empty() && is_separator(s.back()))
+      s.remove_suffix(1);
+    return s;
+  }
+
+#if defined(__SSE2__)
+  // Bit i set when byte i of the 16 at p is a separator
+  static int separator_mask(const char *p)
+  {
+    __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+    __m128i mask = _mm_or_si128(
+        _mm_or_si128(_mm_cmpeq_epi8(chunk, _mm_set1_epi8(' ')), _mm_cmpeq_epi8(chunk, _mm_set1_epi8(','))),
+        _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(chunk, _mm_set1_epi8('\n')), _mm_cmpeq_epi8(chunk, _mm_set1_epi8('\r'))),
+                     _mm_cmpeq_epi8(chunk, _mm_set1_epi8('\t'))));
+    return _mm_movemask_epi8(mask);
+  }
+#endif
+
+  static const char *skip_separators(const char *p, const char *end)
+  {
+#if defined(__SSE2__)
+    while (end - p >= 16)
+    {
+      int token_bits = ~separator_mask(p) & 0xFFFF;
+      if (token_bits)
+        return p + __builtin_ctz(token_bits);
+      p += 16;
+    }
+#endif
+    while (p < end && is_separator(*p))
+      p++;
+    return p;
+  }
+
+  static const char *find_separator(const char *p, const char *end)
+  {
+#if defined(__SSE2__)
+    while (end - p >= 16)
+    {
+      int bits = separator_mask(p);
+      if (bits)
+        return p + __builtin_ctz(bits);
+      p += 16;
+    }
+#endif
+    while (p < end && !is_separator(*p))
+      p++;
+    return p;
+  }
+};
+
+#endif
@@ -0,0 +1,973 @@
+#ifndef __OPTIMIZER_H
+#define __OPTIMIZER_H
+
+#include "ast.hpp"
+#include "number_format.hpp"
+#include "vector_loop.hpp"
+#include <unordered_map>
+#include <vector>
+#include <set>
+#include <string>
+#include <cmath>
+#include <climits>
+
+// AST optimization pass. Runs after TYPE_CHECKER::analyze and before
+// INTERPRETER::execute:
+//   - folds arithmetic, comparison, bitwise, logical and string-concat
+//     operations whose operands are literals,
+//   - propagates the value of 'const' variables initialized with constants,
+//   - prunes if/while/for branches with constant conditions and statements
+//     that follow an unconditional return/break/continue.
+// Folding mirrors the interpreter's runtime semantics exactly; anything that
+// would error or behave differently at runtime (division by zero, overflow,
+// mixed bool/number math) is left in the tree untouched.
+class OPTIMIZER : public AST_VISITOR
+{
+private:
+  // A literal value pulled out of a LITERAL_EXPRESSION
+  struct CONSTANT
+  {
+    enum ConstType
+    {
+      INT,
+      FLOAT,
+      STRING,
+      BOOL
+    } type;
+    long long int_val = 0;
+    double float_val = 0.0;
+    std::string string_val = "";
+    bool bool_val = false;
+  };
+
+  EXPRESSION *last_optimized_expression = nullptr;
+  STATEMENT *last_optimized_statement = nullptr;
+
+  // name -> literal for constants, nullptr for names that shadow one
+  std::vector<std::unordered_map<std::string, LITERAL_EXPRESSION *>> scope_stack;
+  // Inside a method bare names may resolve to 'this' fields, never fold those
+  std::set<std::string> current_class_fields;
+  std::unordered_map<std::string, std::set<std::string>> class_fields;
+
+  void enter_new_scope() { scope_stack.push_back({}); }
+  void exit_current_scope() { scope_stack.pop_back(); }
+
+  void declare_name(std::string name, LITERAL_EXPRESSION *constant) { scope_stack.back()[name] = constant; }
+
+  LITERAL_EXPRESSION *lookup_constant(std::string name)
+  {
+    if (current_class_fields.count(name))
+      return nullptr;
+    for (int i = scope_stack.size() - 1; i >= 0; i--)
+    {
+      auto it = scope_stack[i].find(name);
+      if (it != scope_stack[i].end())
+        return it->second;
+    }
+    return nullptr;
+  }
+
+  EXPRESSION *optimize_expression(EXPRESSION *expr)
+  {
+    if (!expr)
+      return nullptr;
+    last_optimized_expression = expr;
+    expr->accept(this);
+    return last_optimized_expression;
+  }
+
+  // Returns nullptr when the statement was removed entirely
+  STATEMENT *optimize_statement(STATEMENT *stmt)
+  {
+    if (!stmt)
+      return nullptr;
+    last_optimized_statement = stmt;
+    stmt->accept(this);
+    return last_optimized_statement;
+  }
+
+  // Optimizes a statement list in place, dropping removed statements and
+  // everything after an unconditional jump.
+  void optimize_statement_list(std::vector<STATEMENT *> &statements)
+  {
+    std::vector<STATEMENT *> kept;
+    for (auto s : statements)
+    {
+      STATEMENT *optimized = optimize_statement(s);
+      if (!optimized)
+        continue;
+      kept.push_back(optimized);
+      if (optimized->kind == NODE_RETURN_STATEMENT || optimized->kind == NODE_BREAK_STATEMENT || optimized->kind == NODE_CONTINUE_STATEMENT)
+        break;
+    }
+    statements = kept;
+  }
+
+  // Function and method bodies only see globals at runtime
+  void optimize_function_body(FUNCTION_DECLARATION_STATEMENT *func)
+  {
+    auto saved_scopes = scope_stack;
+    scope_stack.resize(1);
+    enter_new_scope();
+    for (auto &p : func->parameters)
+      declare_name(p.name_token.VALUE, nullptr);
+    optimize_statement(func->body_block);
+    scope_stack = saved_scopes;
+  }
+
+  // --- CONSTANT HELPERS ---
+
+  bool get_constant(EXPRESSION *expr, CONSTANT &out)
+  {
+    if (!expr || expr->kind != NODE_LITERAL_EXPRESSION)
+      return false;
+    Token &t = static_cast<LITERAL_EXPRESSION *>(expr)->token;
+    switch (t.TYPE)
+    {
+    case TOKEN_INT_LITERAL:
+      out.type = CONSTANT::INT;
+      out.int_val = std::stoll(t.VALUE);
+      return true;
+    case TOKEN_FLOAT_LITERAL:
+      out.type = CONSTANT::FLOAT;
+      out.float_val = std::stod(t.VALUE);
+      return true;
+    case TOKEN_STRING_LITERAL:
+    case TOKEN_CHAR_LITERAL:
+      out.type = CONSTANT::STRING;
+      out.string_val = t.VALUE;
+      return true;
+    case TOKEN_TRUE:
+    case TOKEN_FALSE:
+      out.type = CONSTANT::BOOL;
+      out.bool_val = t.TYPE == TOKEN_TRUE;
+      return true;
+    default:
+      return false; // null is left alone
+    }
+  }
+
+  LITERAL_EXPRESSION *make_literal(const CONSTANT &c, int line)
+  {
+    Token t;
+    t.line = line;
+    switch (c.type)
+    {
+    case CONSTANT::INT:
+      t.TYPE = TOKEN_INT_LITERAL;
+      t.VALUE = NUMBER_FORMATTER::to_string(c.int_val);
+      break;
+    case CONSTANT::FLOAT:
+      // Shortest round-trip text reads back through std::stod unchanged
+      t.TYPE = TOKEN_FLOAT_LITERAL;
+      t.VALUE = NUMBER_FORMATTER::to_string(c.float_val);
+      break;
+    case CONSTANT::STRING:
+      t.TYPE = TOKEN_STRING_LITERAL;
+      t.VALUE = c.string_val;
+      break;
+    case CONSTANT::BOOL:
+      t.TYPE = c.bool_val ? TOKEN_TRUE : TOKEN_FALSE;
+      t.VALUE = c.bool_val ? "true" : "false";
+      break;
+    }
+    return new LITERAL_EXPRESSION(t);
+  }
+
+  CONSTANT make_int(long long v)
+  {
+    CONSTANT c;
+    c.type = CONSTANT::INT;
+    c.int_val = v;
+    return c;
+  }
+  CONSTANT make_float(double v)
+  {
+    CONSTANT c;
+    c.type = CONSTANT::FLOAT;
+    c.float_val = v;
+    return c;
+  }
+  CONSTANT make_bool(bool v)
+  {
+    CONSTANT c;
+    c.type = CONSTANT::BOOL;
+    c.bool_val = v;
+    return c;
+  }
+  CONSTANT make_string(std::string v)
+  {
+    CONSTANT c;
+    c.type = CONSTANT::STRING;
+    c.string_val = v;
+    return c;
+  }
+
+  // Same truthiness rules as INTERPRETER::is_truthy
+  bool is_truthy(const CONSTANT &c)
+  {
+    if (c.type == CONSTANT::BOOL)
+      return c.bool_val;
+    if (c.type == CONSTANT::INT)
+      return c.int_val != 0;
+    return false;
+  }
+
+  bool is_number(const CONSTANT &c) { return c.type == CONSTANT::INT || c.type == CONSTANT::FLOAT; }
+
+  // Same conversion the interpreter applies in string concatenation
+  std::string to_concat_string(const CONSTANT &c)
+  {
+    switch (c.type)
+    {
+    case CONSTANT::STRING:
+      return c.string_val;
+    case CONSTANT::INT:
+      return NUMBER_FORMATTER::to_string(c.int_val);
+    case CONSTANT::BOOL:
+      return c.bool_val ? "true" : "false";
+    default:
+      return NUMBER_FORMATTER::to_string(c.float_val);
+    }
+  }
+
+  bool fold_binary(enum type op, const CONSTANT &left, const CONSTANT &right, CONSTANT &out)
+  {
+    if (left.type == CONSTANT::BOOL && right.type == CONSTANT::BOOL)
+    {
+      if (op == TOKEN_DOUBLE_EQUALS)
+      {
+        out = make_bool(left.bool_val == right.bool_val);
+        return true;
+      }
+      if (op == TOKEN_NOT_EQUALS)
+      {
+        out = make_bool(left.bool_val != right.bool_val);
+        return true;
+      }
+      return false;
+    }
+
+    if (op == TOKEN_PLUS && (left.type == CONSTANT::STRING || right.type == CONSTANT::STRING))
+    {
+      out = make_string(to_concat_string(left) + to_concat_string(right));
+      return true;
+    }
+
+    if (!is_number(left) || !is_number(right))
+      return false;
+
+    double l_val = (left.type == CONSTANT::INT) ? (double)left.int_val : left.float_val;
+    double r_val = (right.type == CONSTANT::INT) ? (double)right.int_val : right.float_val;
+    bool are_ints = (left.type == CONSTANT::INT && right.type == CONSTANT::INT);
+    long long result;
+
+    switch (op)
+    {
+    case TOKEN_PLUS:
+      if (!are_ints)
+        out = make_float(l_val + r_val);
+      else if (__builtin_add_overflow(left.int_val, right.int_val, &result))
+        return false;
+      else
+        out = make_int(result);
+      return true;
+    case TOKEN_MINUS:
+      if (!are_ints)
+        out = make_float(l_val - r_val);
+      else if (__builtin_sub_overflow(left.int_val, right.int_val, &result))
+        return false;
+      else
+        out = make_int(result);
+      return true;
+    case TOKEN_ASTERISK:
+      if (!are_ints)
+        out = make_float(l_val * r_val);
+      else if (__builtin_mul_overflow(left.int_val, right.int_val, &result))
+        return false;
+      else
+        out = make_int(result);
+      return true;
+    case TOKEN_SLASH:
+      if (r_val == 0)
+        return false; // Keep the runtime error
+      if (!are_ints)
+        out = make_float(l_val / r_val);
+      else if (left.int_val == LLONG_MIN && right.int_val == -1)
+        return false;
+      else
+        out = make_int(left.int_val / right.int_val);
+      return true;
+    case TOKEN_PERCENT:
+      if (!are_ints || right.int_val == 0 || (left.int_val == LLONG_MIN && right.int_val == -1))
+        return false;
+      out = make_int(left.int_val % right.int_val);
+      return true;
+    case TOKEN_GREATER_THAN:
+      out = make_bool(l_val > r_val);
+      return true;
+    case TOKEN_LESS_THAN:
+      out = make_bool(l_val < r_val);
+      return true;
+    case TOKEN_GREATER_EQUAL:
+      out = make_bool(l_val >= r_val);
+      return true;
+    case TOKEN_LESS_EQUAL:
+      out = make_bool(l_val <= r_val);
+      return true;
+    case TOKEN_DOUBLE_EQUALS:
+      out = make_bool(l_val == r_val);
+      return true;
+    case TOKEN_NOT_EQUALS:
+      out = make_bool(l_val != r_val);
+      return true;
+    default:
+      return false;
+    }
+  }
+
+  bool fold_bitwise(enum type op, const CONSTANT &left, const CONSTANT &right, CONSTANT &out)
+  {
+    if (left.type != CONSTANT::INT || right.type != CONSTANT::INT)
+      return false;
+    switch (op)
+    {
+    case TOKEN_BITWISE_AND:
+      out = make_int(left.int_val & right.int_val);
+      return true;
+    case TOKEN_BITWISE_OR:
+      out = make_int(left.int_val | right.int_val);
+      return true;
+    case TOKEN_BITWISE_XOR:
+      out = make_int(left.int_val ^ right.int_val);
+      return true;
+    case TOKEN_LEFT_SHIFT:
+      if (right.int_val < 0 || right.int_val >= 64 || left.int_val < 0)
+        return false;
+      out = make_int((long long)((unsigned long long)left.int_val << right.int_val));
+      return true;
+    case TOKEN_RIGHT_SHIFT:
+      if (right.int_val < 0 || right.int_val >= 64)
+        return false;
+      out = make_int(left.int_val >> right.int_val);
+      return true;
+    default:
+      return false;
+    }
+  }
+
+  // Constant-condition test for if/while/for: 1 = always true, 0 = always
+  // false, -1 = unknown.
+  int constant_condition(EXPRESSION *condition)
+  {
+    CONSTANT c;
+    if (!get_constant(condition, c))
+      return -1;
+    return is_truthy(c) ? 1 : 0;
+  }
+
+public:
+  OPTIMIZER() { enter_new_scope(); }
+
+  std::vector<STATEMENT *> optimize(std::vector<STATEMENT *> program)
+  {
+    optimize_statement_list(program);
+    return program;
+  }
+
+  // ==========================================
+  //          EXPRESSIONS
+  // ==========================================
+
+  void visit(LITERAL_EXPRESSION *expr) override { last_optimized_expression = expr; }
+
+  void visit(VARIABLE_EXPRESSION *expr) override
+  {
+    LITERAL_EXPRESSION *constant = lookup_constant(expr->name.VALUE);
+    last_optimized_expression = constant ? (EXPRESSION *)new LITERAL_EXPRESSION(constant->token) : expr;
+  }
+
+  void visit(BINARY_EXPRESSION *expr) override
+  {
+    expr->left_operand = optimize_expression(expr->left_operand);
+    expr->right_operand = optimize_expression(expr->right_operand);
+    last_optimized_expression = expr;
+
+    CONSTANT left, right, result;
+    if (get_constant(expr->left_operand, left) && get_constant(expr->right_operand, right) &&
+        fold_binary(expr->operator_token.TYPE, left, right, result))
+      last_optimized_expression = make_literal(result, expr->operator_token.line);
+    else if (expr->is_string_concat)
+      last_optimized_expression = fuse_concat(expr);
+  }
+
+  // Flattens a left-nested string '+' chain into one CONCAT_EXPRESSION.
+  // Right operands stay whole: (a + (b + c)) keeps (b + c) as a single part.
+  EXPRESSION *fuse_concat(BINARY_EXPRESSION *expr)
+  {
+    std::vector<EXPRESSION *> parts;
+    if (expr->left_operand->kind == NODE_CONCAT_EXPRESSION)
+      parts = static_cast<CONCAT_EXPRESSION *>(expr->left_operand)->parts;
+    else
+      parts.push_back(expr->left_operand);
+    parts.push_back(expr->right_operand);
+
+    // Once a string literal leads the chain every step is a plain append,
+    // so neighbouring literals can be merged ahead of time.
+    CONSTANT first, second;
+    bool leads_with_string = (get_constant(parts[0], first) && first.type == CONSTANT::STRING) ||
+                             (get_constant(parts[1], second) && second.type == CONSTANT::STRING);
+    if (leads_with_string)
+    {
+      std::vector<EXPRESSION *> merged;
+      for (auto part : parts)
+      {
+        CONSTANT previous, current;
+        if (!merged.empty() && get_constant(merged.back(), previous) && get_constant(part, current))
+          merged.back() = make_literal(make_string(to_concat_string(previous) + to_concat_string(current)), expr->operator_token.line);
+        else
+          merged.push_back(part);
+      }
+      parts = merged;
+      if (parts.size() == 1)
+        return parts[0];
+    }
+    return new CONCAT_EXPRESSION(parts);
+  }
+
+  void visit(CONCAT_EXPRESSION *expr) override
+  {
+    for (auto &part : expr->parts)
+      part = optimize_expression(part);
+    last_optimized_expression = expr;
+  }
+
+  void visit(BITWISE_EXPRESSION *expr) override
+  {
+    expr->left_operand = optimize_expression(expr->left_operand);
+    expr->right_operand = optimize_expression(expr->right_operand);
+    last_optimized_expression = expr;
+
+    CONSTANT left, right, result;
+    if (get_constant(expr->left_operand, left) && get_constant(expr->right_operand, right) &&
+        fold_bitwise(expr->operator_token.TYPE, left, right, result))
+      last_optimized_expression = make_literal(result, expr->operator_token.line);
+  }
+
+  void visit(LOGICAL_EXPRESSION *expr) override
+  {
+    expr->left_operand = optimize_expression(expr->left_operand);
+    expr->right_operand = optimize_expression(expr->right_operand);
+    last_optimized_expression = expr;
+
+    CONSTANT left, right;
+    if (!get_constant(expr->left_operand, left))
+      return;
+    bool is_and = expr->operator_token.TYPE == TOKEN_AND;
+
+    // Short-circuit decided by the left side alone
+    if (is_and != is_truthy(left))
+    {
+      last_optimized_expression = make_literal(make_bool(!is_and), expr->operator_token.line);
+      return;
+    }
+    if (get_constant(expr->right_operand, right))
+      last_optimized_expression = make_literal(make_bool(is_truthy(right)), expr->operator_token.line);
+  }
+
+  void visit(UNARY_EXPRESSION *expr) override
+  {
+    expr->right_operand = optimize_expression(expr->right_operand);
+    last_optimized_expression = expr;
+
+    CONSTANT operand;
+    if (!get_constant(expr->right_operand, operand))
+      return;
+    int line = expr->operator_token.line;
+    switch (expr->operator_token.TYPE)
+    {
+    case TOKEN_MINUS:
+      if (operand.type == CONSTANT::INT && operand.int_val != LLONG_MIN)
+        last_optimized_expression = make_literal(make_int(-operand.int_val), line);
+      else if (operand.type == CONSTANT::FLOAT)
+        last_optimized_expression = make_literal(make_float(-operand.float_val), line);
+      break;
+    case TOKEN_NOT:
+      last_optimized_expression = make_literal(make_bool(!is_truthy(operand)), line);
+      break;
+    case TOKEN_BITWISE_NOT:
+      if (operand.type == CONSTANT::INT)
+        last_optimized_expression = make_literal(make_int(~operand.int_val), line);
+      break;
+    default:
+      break;
+    }
+  }
+
+  // Only the index of an array target may fold, the rest is a storage location
+  void optimize_target(EXPRESSION *target)
+  {
+    while (target->kind == NODE_ARRAY_ACCESS_EXPRESSION)
+    {
+      auto access = static_cast<ARRAY_ACCESS_EXPRESSION *>(target);
+      access->index_expression = optimize_expression(access->index_expression);
+      target = access->array_expression;
+    }
+  }
+
+  void visit(INCREMENT_EXPRESSION *expr) override
+  {
+    optimize_target(expr->variable);
+    last_optimized_expression = expr;
+  }
+
+  void visit(COMPOUND_ASSIGNMENT_EXPRESSION *expr) override
+  {
+    optimize_target(expr->target);
+    expr->value_expression = optimize_expression(expr->value_expression);
+    last_optimized_expression = expr;
+  }
+
+  void visit(CALL_EXPRESSION *expr) override
+  {
+    for (auto &arg : expr->arguments)
+      arg = optimize_expression(arg);
+
+    if (expr->target == CALL_EXPRESSION::CALL_METHOD)
+    {
+      // obj.push(...) writes back through the object expression, keep it an lvalue
+      auto get_expr = static_cast<GET_EXPRESSION *>(expr->callee);
+      if (get_expr->object_expression->kind != NODE_VARIABLE_EXPRESSION)
+        get_expr->object_expression = optimize_expression(get_expr->object_expression);
+    }
+    last_optimized_expression = expr;
+    if (expr->target != CALL_EXPRESSION::CALL_FUNCTION || expr->arguments.size() != 1)
+      return;
+
+    // Casts on constants: int(...), float(...), string(...)
+    std::string name = static_cast<VARIABLE_EXPRESSION *>(expr->callee)->name.VALUE;
+    CONSTANT arg;
+    if (!get_constant(expr->arguments[0], arg))
+      return;
+    int line = static_cast<VARIABLE_EXPRESSION *>(expr->callee)->name.line;
+
+    if (name == "int")
+    {
+      if (arg.type == CONSTANT::INT)
+        last_optimized_expression = make_literal(arg, line);
+      else if (arg.type == CONSTANT::BOOL)
+        last_optimized_expression = make_literal(make_int(arg.bool_val ? 1 : 0), line);
+      else if (arg.type == CONSTANT::FLOAT && std::isfinite(arg.float_val) && std::fabs(arg.float_val) < 9.2e18)
+        last_optimized_expression = make_literal(make_int((long long)arg.float_val), line);
+    }
+    else if (name == "float")
+    {
+      if (arg.type == CONSTANT::INT)
+        last_optimized_expression = make_literal(make_float(arg.int_val), line);
+      else if (arg.type == CONSTANT::BOOL)
+        last_optimized_expression = make_literal(make_float(arg.bool_val ? 1.0 : 0.0), line);
+      else if (arg.type == CONSTANT::FLOAT)
+        last_optimized_expression = make_literal(arg, line);
+    }
+    else if (name == "string")
+    {
+      last_optimized_expression = make_literal(make_string(to_concat_string(arg)), line);
+    }
+  }
+
+  void visit(INPUT_EXPRESSION *expr) override
+  {
+    expr->prompt_expression = optimize_expression(expr->prompt_expression);
+    last_optimized_expression = expr;
+  }
+
+  void visit(ARRAY_LITERAL_EXPRESSION *expr) override
+  {
+    for (auto &el : expr->elements)
+      el = optimize_expression(el);
+    last_optimized_expression = expr;
+  }
+
+  void visit(ARRAY_ACCESS_EXPRESSION *expr) override
+  {
+    expr->array_expression = optimize_expression(expr->array_expression);
+    expr->index_expression = optimize_expression(expr->index_expression);
+    last_optimized_expression = expr;
+  }
+
+  void visit(ARRAY_ASSIGNMENT_EXPRESSION *expr) override
+  {
+    // array_expression is written back to, only the index and value fold
+    expr->index_expression = optimize_expression(expr->index_expression);
+    expr->value_expression = optimize_expression(expr->value_expression);
+    last_optimized_expression = expr;
+  }
+
+  void visit(ASSIGNMENT_EXPRESSION *expr) override
+  {
+    expr->value_expression = optimize_expression(expr->value_expression);
+    last_optimized_expression = expr;
+  }
+
+  void visit(NEW_EXPRESSION *expr) override
+  {
+    for (auto &arg : expr->arguments)
+      arg = optimize_expression(arg);
+    last_optimized_expression = expr;
+  }
+
+  void visit(SUPER_EXPRESSION *expr) override { last_optimized_expression = expr; }
+
+  void visit(GET_EXPRESSION *expr) override
+  {
+    expr->object_expression = optimize_expression(expr->object_expression);
+    last_optimized_expression = expr;
+  }
+
+  void visit(SET_EXPRESSION *expr) override
+  {
+    expr->object_expression = optimize_expression(expr->object_expression);
+    expr->value_expression = optimize_expression(expr->value_expression);
+    last_optimized_expression = expr;
+  }
+
+  // ==========================================
+  //          STATEMENTS
+  // ==========================================
+
+  void visit(EXPRESSION_STATEMENT *stmt) override
+  {
+    stmt->expression = optimize_expression(stmt->expression);
+    mark_string_append(stmt->expression);
+    last_optimized_statement = stmt;
+  }
+
+  // Whether evaluating an expression can only read state: no calls (except
+  // the int/float/string conversions), input or assignments
+  bool is_read_only(EXPRESSION *expr)
+  {
+    switch (expr->kind)
+    {
+    case NODE_LITERAL_EXPRESSION:
+    case NODE_VARIABLE_EXPRESSION:
+      return true;
+    case NODE_BINARY_EXPRESSION:
+    {
+      auto binary = static_cast<BINARY_EXPRESSION *>(expr);
+      return is_read_only(binary->left_operand) && is_read_only(binary->right_operand);
+    }
+    case NODE_BITWISE_EXPRESSION:
+    {
+      auto bitwise = static_cast<BITWISE_EXPRESSION *>(expr);
+      return is_read_only(bitwise->left_operand) && is_read_only(bitwise->right_operand);
+    }
+    case NODE_LOGICAL_EXPRESSION:
+    {
+      auto logical = static_cast<LOGICAL_EXPRESSION *>(expr);
+      return is_read_only(logical->left_operand) && is_read_only(logical->right_operand);
+    }
+    case NODE_UNARY_EXPRESSION:
+      return is_read_only(static_cast<UNARY_EXPRESSION *>(expr)->right_operand);
+    case NODE_CONCAT_EXPRESSION:
+      for (auto part : static_cast<CONCAT_EXPRESSION *>(expr)->parts)
+        if (!is_read_only(part))
+          return false;
+      return true;
+    case NODE_ARRAY_ACCESS_EXPRESSION:
+    {
+      auto access = static_cast<ARRAY_ACCESS_EXPRESSION *>(expr);
+      return is_read_only(access->array_expression) && is_read_only(access->index_expression);
+    }
+    case NODE_GET_EXPRESSION:
+      return is_read_only(static_cast<GET_EXPRESSION *>(expr)->object_expression);
+    case NODE_CALL_EXPRESSION:
+    {
+      auto call = static_cast<CALL_EXPRESSION *>(expr);
+      if (call->target != CALL_EXPRESSION::CALL_FUNCTION)
+        return false;
+      const std::string &name = static_cast<VARIABLE_EXPRESSION *>(call->callee)->name.VALUE;
+      if (name != "int" && name != "float" && name != "string")
+        return false;
+      for (auto arg : call->arguments)
+        if (!is_read_only(arg))
+          return false;
+      return true;
+    }
+    default:
+      return false;
+    }
+  }
+
+  // Statement-level 's = s + a + b' and 's += a' (value unused) can append
+  // to s's own buffer instead of rebuilding s, as long as the appended parts
+  // cannot change s while they are evaluated. The interpreter still checks
+  // that s holds a string.
+  void mark_string_append(EXPRESSION *expr)
+  {
+    if (expr->kind == NODE_ASSIGNMENT_EXPRESSION)
+    {
+      auto assign = static_cast<ASSIGNMENT_EXPRESSION *>(expr);
+      if (assign->value_expression->kind != NODE_CONCAT_EXPRESSION)
+        return;
+      auto &parts = static_cast<CONCAT_EXPRESSION *>(assign->value_expression)->parts;
+      if (parts[0]->kind != NODE_VARIABLE_EXPRESSION ||
+          static_cast<VARIABLE_EXPRESSION *>(parts[0])->name.VALUE != assign->variable_name.VALUE)
+        return;
+      for (size_t i = 1; i < parts.size(); i++)
+        if (!is_read_only(parts[i]))
+          return;
+      assign->appends_to_target = true;
+    }
+    else if (expr->kind == NODE_COMPOUND_ASSIGNMENT_EXPRESSION)
+    {
+      auto compound = static_cast<COMPOUND_ASSIGNMENT_EXPRESSION *>(expr);
+      if (compound->operator_token.TYPE == TOKEN_PLUS && compound->target->kind == NODE_VARIABLE_EXPRESSION &&
+          is_read_only(compound->value_expression))
+        compound->appends_to_target = true;
+    }
+  }
+
+  void visit(PRINT_STATEMENT *stmt) override
+  {
+    stmt->expression = optimize_expression(stmt->expression);
+    last_optimized_statement = stmt;
+  }
+
+  void visit(VARIABLE_DECLARATION_STATEMENT *stmt) override
+  {
+    stmt->initializer_expression = optimize_expression(stmt->initializer_expression);
+
+    LITERAL_EXPRESSION *constant = nullptr;
+    if (stmt->is_constant && stmt->initializer_expression && stmt->initializer_expression->kind == NODE_LITERAL_EXPRESSION)
+    {
+      constant = static_cast<LITERAL_EXPRESSION *>(stmt->initializer_expression);
+      if (constant->token.TYPE == TOKEN_NULL)
+        constant = nullptr;
+    }
+    declare_name(stmt->name_token.VALUE, constant);
+    last_optimized_statement = stmt;
+  }
+
+  void visit(BLOCK_STATEMENT *stmt) override
+  {
+    enter_new_scope();
+    optimize_statement_list(stmt->statements);
+    exit_current_scope();
+    last_optimized_statement = stmt;
+  }
+
+  void visit(IF_STATEMENT *stmt) override
+  {
+    stmt->condition_expression = optimize_expression(stmt->condition_expression);
+    stmt->then_branch_statement = optimize_statement(stmt->then_branch_statement);
+    stmt->else_branch_statement = optimize_statement(stmt->else_branch_statement);
+
+    int condition = constant_condition(stmt->condition_expression);
+    if (condition == 1)
+      last_optimized_statement = stmt->then_branch_statement;
+    else if (condition == 0)
+      last_optimized_statement = stmt->else_branch_statement;
+    else
+    {
+      if (!stmt->then_branch_statement)
+        stmt->then_branch_statement = new BLOCK_STATEMENT({});
+      last_optimized_statement = stmt;
+    }
+  }
+
+  void visit(SWITCH_STATEMENT *stmt) override
+  {
+    stmt->value = optimize_expression(stmt->value);
+    for (auto &c : stmt->cases)
+    {
+      c.condition = optimize_expression(c.condition);
+      optimize_statement_list(c.statements);
+    }
+    last_optimized_statement = stmt;
+  }
+
+  void visit(WHILE_STATEMENT *stmt) override
+  {
+    stmt->condition_expression = optimize_expression(stmt->condition_expression);
+    if (constant_condition(stmt->condition_expression) == 0)
+    {
+      last_optimized_statement = nullptr;
+      return;
+    }
+    stmt->body_statement = optimize_statement(stmt->body_statement);
+    if (!stmt->body_statement)
+      stmt->body_statement = new BLOCK_STATEMENT({});
+    last_optimized_statement = stmt;
+  }
+
+  void visit(FOR_STATEMENT *stmt) override
+  {
+    enter_new_scope();
+    stmt->initializer = optimize_statement(stmt->initializer);
+    stmt->condition = optimize_expression(stmt->condition);
+
+    if (constant_condition(stmt->condition) == 0)
+    {
+      exit_current_scope();
+      // Only the initializer ever runs; a declaration there is loop-scoped
+      if (stmt->initializer && stmt->initializer->kind == NODE_EXPRESSION_STATEMENT)
+        last_optimized_statement = stmt->initializer;
+      else
+        last_optimized_statement = nullptr;
+      return;
+    }
+
+    stmt->increment = optimize_expression(stmt->increment);
+    stmt->body = optimize_statement(stmt->body);
+    if (!stmt->body)
+      stmt->body = new BLOCK_STATEMENT({});
+    exit_current_scope();
+    stmt->counted_step = counted_step(stmt);
+    stmt->vector_loop = VECTOR_LOOP::plan(stmt);
+    last_optimized_statement = stmt;
+  }
+
+  void visit(FOREACH_STATEMENT *stmt) override
+  {
+    stmt->collection = optimize_expression(stmt->collection);
+    enter_new_scope();
+    declare_name(stmt->name_token.VALUE, nullptr); // hides any outer constant of that name
+    stmt->body = optimize_statement(stmt->body);
+    if (!stmt->body)
+      stmt->body = new BLOCK_STATEMENT({});
+    exit_current_scope();
+    last_optimized_statement = stmt;
+  }
+
+  // --- COUNTED LOOPS ---
+
+  static bool is_variable(EXPRESSION *expr, const std::string &name)
+  {
+    return expr && expr->kind == NODE_VARIABLE_EXPRESSION && static_cast<VARIABLE_EXPRESSION *>(expr)->name.VALUE == name;
+  }
+
+  static bool is_int_literal(EXPRESSION *expr, const std::string &text)
+  {
+    return expr->kind == NODE_LITERAL_EXPRESSION && static_cast<LITERAL_EXPRESSION *>(expr)->token.TYPE == TOKEN_INT_LITERAL &&
+           static_cast<LITERAL_EXPRESSION *>(expr)->token.VALUE == text;
+  }
+
+  // +1 / -1 when the increment steps 'counter' by one, 0 otherwise
+  static int unit_step(EXPRESSION *increment, const std::string &counter)
+  {
+    if (!increment)
+      return 0;
+    if (increment->kind == NODE_INCREMENT_EXPRESSION)
+    {
+      auto inc = static_cast<INCREMENT_EXPRESSION *>(increment);
+      if (!is_variable(inc->variable, counter))
+        return 0;
+      return inc->operator_token.TYPE == TOKEN_INCREMENT ? 1 : -1;
+    }
+    enum type op;
+    EXPRESSION *amount;
+    if (increment->kind == NODE_COMPOUND_ASSIGNMENT_EXPRESSION)
+    {
+      auto compound = static_cast<COMPOUND_ASSIGNMENT_EXPRESSION *>(increment);
+      if (!is_variable(compound->target, counter))
+        return 0;
+      op = compound->operator_token.TYPE;
+      amount = compound->value_expression;
+    }
+    else if (increment->kind == NODE_ASSIGNMENT_EXPRESSION)
+    {
+      auto assign = static_cast<ASSIGNMENT_EXPRESSION *>(increment);
+      if (assign->variable_name.VALUE != counter || assign->value_expression->kind != NODE_BINARY_EXPRESSION)
+        return 0;
+      auto sum = static_cast<BINARY_EXPRESSION *>(assign->value_expression);
+      if (!is_variable(sum->left_operand, counter))
+        return 0;
+      op = sum->operator_token.TYPE;
+      amount = sum->right_operand;
+    }
+    else
+      return 0;
+    if (!is_int_literal(amount, "1"))
+      return 0;
+    return op == TOKEN_PLUS ? 1 : op == TOKEN_MINUS ? -1 : 0;
+  }
+
+  // See FOR_STATEMENT::counted_step. Only the loop's shape is checked here;
+  // the interpreter checks the runtime types before taking the fast path.
+  int counted_step(FOR_STATEMENT *stmt)
+  {
+    if (!stmt->initializer || stmt->initializer->kind != NODE_VARIABLE_DECLARATION_STATEMENT || !stmt->condition ||
+        stmt->condition->kind != NODE_BINARY_EXPRESSION)
+      return 0;
+    auto declaration = static_cast<VARIABLE_DECLARATION_STATEMENT *>(stmt->initializer);
+    const std::string &type = declaration->type_token.VALUE;
+    const std::string &counter = declaration->name_token.VALUE;
+    if (type != "int" && type != "short" && type != "long")
+      return 0;
+
+    auto condition = static_cast<BINARY_EXPRESSION *>(stmt->condition);
+    enum type op = condition->operator_token.TYPE;
+    if (!is_variable(condition->left_operand, counter) ||
+        (op != TOKEN_LESS_THAN && op != TOKEN_LESS_EQUAL && op != TOKEN_GREATER_THAN && op != TOKEN_GREATER_EQUAL))
+      return 0;
+    EXPRESSION *limit = condition->right_operand;
+    bool simple_limit = false;
+    if (limit->kind == NODE_LITERAL_EXPRESSION)
+      simple_limit = static_cast<LITERAL_EXPRESSION *>(limit)->token.TYPE == TOKEN_INT_LITERAL;
+    else if (limit->kind == NODE_VARIABLE_EXPRESSION)
+      simple_limit = !is_variable(limit, counter);
+    else if (limit->kind == NODE_GET_EXPRESSION)
+    {
+      auto get = static_cast<GET_EXPRESSION *>(limit);
+      simple_limit = get->member_name.VALUE == "length" && get->object_expression->kind == NODE_VARIABLE_EXPRESSION;
+    }
+    // A declaration as the whole body would define names in the loop's own
+    // scope, where the bound was looked up
+    if (!simple_limit || stmt->body->kind == NODE_VARIABLE_DECLARATION_STATEMENT)
+      return 0;
+    return unit_step(stmt->increment, counter);
+  }
+
+  void visit(BREAK_STATEMENT *stmt) override { last_optimized_statement = stmt; }
+  void visit(CONTINUE_STATEMENT *stmt) override { last_optimized_statement = stmt; }
+
+  void visit(RETURN_STATEMENT *stmt) override
+  {
+    stmt->value_expression = optimize_expression(stmt->value_expression);
+    last_optimized_statement = stmt;
+  }
+
+  void visit(FUNCTION_DECLARATION_STATEMENT *stmt) override
+  {
+    optimize_function_body(stmt);
+    last_optimized_statement = stmt;
+  }
+
+  void visit(CLASS_DECLARATION_STATEMENT *stmt) override
+  {
+    // Inherited fields are visible as bare names too
+    std::set<std::string> fields = class_fields[stmt->superclass_token.VALUE];
+    for (auto field : stmt->fields)
+      fields.insert(field->name_token.VALUE);
+    class_fields[stmt->name_token.VALUE] = fields;
+
+    auto saved_fields = current_class_fields;
+    current_class_fields = fields;
+
+    auto saved_scopes = scope_stack;
+    scope_stack.resize(1);
+    for (auto field : stmt->fields)
+      field->initializer_expression = optimize_expression(field->initializer_expression);
+    scope_stack = saved_scopes;
+
+    for (auto method : stmt->methods)
+      optimize_function_body(method);
+    current_class_fields = saved_fields;
+    last_optimized_statement = stmt;
+  }
+
+  // Struct field initializers never run
+  void visit(STRUCT_DECLARATION_STATEMENT *stmt) override { last_optimized_statement = stmt; }
+};
+
+#endif
@@ -0,0 +1,278 @@
+#ifndef __OUTPUT_WRITER_H
+#define __OUTPUT_WRITER_H
+
+#include <iostream>
+#include <streambuf>
+#include <vector>
+#include <string>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <chrono>
+#include <memory>
+
+// Single-producer/single-consumer byte ring between the interpreter thread
+// (push) and the async writer thread (pop). head and tail only grow; their
+// difference is the number of bytes in flight.
+class OUTPUT_RING
+{
+public:
+  static constexpr size_t CAPACITY = 1 << 20; // power of two
+
+  OUTPUT_RING() : data(CAPACITY) {}
+
+  // Producer side: copies all bytes in, waiting only while the ring is full
+  void push(const char *bytes, size_t count)
+  {
+    size_t head_pos = head.load(std::memory_order_relaxed);
+    while (count > 0)
+    {
+      size_t free_bytes = CAPACITY - (head_pos - tail.load(std::memory_order_acquire));
+      if (free_bytes == 0)
+      {
+        std::this_thread::yield();
+        continue;
+      }
+      size_t chunk = std::min(count, free_bytes);
+      size_t offset = head_pos & (CAPACITY - 1);
+      size_t first = std::min(chunk, CAPACITY - offset);
+      std::memcpy(data.data() + offset, bytes, first);
+      std::memcpy(data.data(), bytes + first, chunk - first);
+      head_pos += chunk;
+      head.store(head_pos, std::memory_order_release);
+      bytes += chunk;
+      count -= chunk;
+    }
+  }
+
+  // Consumer side: writes whatever is buffered to stdout; false if empty
+  bool pop_to_stdout()
+  {
+    size_t tail_pos = tail.load(std::memory_order_relaxed);
+    size_t available = head.load(std::memory_order_acquire) - tail_pos;
+    if (available == 0)
+      return false;
+    size_t offset = tail_pos & (CAPACITY - 1);
+    size_t first = std::min(available, CAPACITY - offset);
+    std::fwrite(data.data() + offset, 1, first, stdout);
+    std::fwrite(data.data(), 1, available - first, stdout);
+    tail.store(tail_pos + available, std::memory_order_release);
+    return true;
+  }
+
+  // True once the consumer has written every pushed byte
+  bool empty() const { return head.load(std::memory_order_acquire) == tail.load(std::memory_order_acquire); }
+
+private:
+  std::vector<char> data;
+  std::atomic<size_t> head{0}; // next byte the producer writes
+  std::atomic<size_t> tail{0}; // next byte the consumer reads
+};
+
+// Buffered program output. Installed as std::cout's stream buffer, so every
+// print, prompt and banner goes through one buffer and reaches stdout in
+// large writes instead of one write per line.
+//
+// Flush modes (--flush=...):
+//   line        - write after every newline (the old std::endl behaviour)
+//   block       - write only when the buffer fills and at exit
+//   interactive - like block, but also write before input() reads a line
+//   async       - hand each line to a writer thread through a lock-free
+//                 ring; the interpreter only waits when the ring is full
+//
+// Every mode writes pending output before an error message on std::cerr
+// (cerr is tied to cout) and when the process exits.
+// An optional cap (--max-output=BYTES) stops the program once it has
+// written that many bytes.
+class OUTPUT_WRITER : public std::streambuf
+{
+public:
+  enum FLUSH_MODE
+  {
+    FLUSH_LINE,
+    FLUSH_BLOCK,
+    FLUSH_INTERACTIVE,
+    FLUSH_ASYNC
+  };
+
+  static constexpr size_t BUFFER_SIZE = 1 << 16;
+
+  OUTPUT_WRITER(FLUSH_MODE m, unsigned long long limit) : mode(m), max_bytes(limit), buffer(BUFFER_SIZE)
+  {
+    setp(buffer.data(), buffer.data() + buffer.size());
+  }
+
+  static bool parse_mode(const std::string &name, FLUSH_MODE &out)
+  {
+    if (name == "line")
+      out = FLUSH_LINE;
+    else if (name == "block")
+      out = FLUSH_BLOCK;
+    else if (name == "interactive")
+      out = FLUSH_INTERACTIVE;
+    else if (name == "async")
+      out = FLUSH_ASYNC;
+    else
+      return false;
+    return true;
+  }
+
+  // Routes std::cout through a new writer for the rest of the run. The
+  // writer is never freed: std::cout still flushes it while the process exits.
+  static OUTPUT_WRITER *install(FLUSH_MODE mode, unsigned long long max_bytes)
+  {
+    OUTPUT_WRITER *writer = new OUTPUT_WRITER(mode, max_bytes);
+    std::setvbuf(stdout, nullptr, _IONBF, 0); // our buffer is the only one
+    std::cout.rdbuf(writer);
+
+    // std::cin is tied to std::cout, and LINE_READER flushes the tied stream
+    // before waiting on stdin, so input() prompts show up first.
+    // Block mode opts out of that and only writes full buffers.
+    if (mode == FLUSH_BLOCK)
+      std::cin.tie(nullptr);
+
+    if (mode == FLUSH_ASYNC)
+    {
+      writer->ring.reset(new OUTPUT_RING());
+      writer->writer_thread = std::thread(&OUTPUT_WRITER::run_writer_thread, writer);
+      active_writer = writer;
+      // Runs before std::cout's own exit-time flush
+      std::atexit([]
+                  { active_writer->stop_writer_thread(); });
+    }
+    return writer;
+  }
+
+protected:
+  int_type overflow(int_type ch) override
+  {
+    if (!drain())
+      return traits_type::eof();
+    if (!traits_type::eq_int_type(ch, traits_type::eof()))
+    {
+      *pptr() = traits_type::to_char_type(ch);
+      pbump(1);
+      if ((mode == FLUSH_LINE || mode == FLUSH_ASYNC) && ch == '\n')
+        drain();
+    }
+    return traits_type::not_eof(ch);
+  }
+
+  std::streamsize xsputn(const char *data, std::streamsize count) override
+  {
+    std::streamsize written = 0;
+    while (written < count)
+    {
+      if (pptr() == epptr() && !drain())
+        return written;
+      std::streamsize chunk = std::min<std::streamsize>(epptr() - pptr(), count - written);
+      std::memcpy(pptr(), data + written, chunk);
+      pbump((int)chunk);
+      written += chunk;
+    }
+    if ((mode == FLUSH_LINE || mode == FLUSH_ASYNC) && std::memchr(data, '\n', count))
+      drain();
+    return count;
+  }
+
+  // An explicit flush (input(), an error on std::cerr, exit) must see every
+  // byte on stdout, so in async mode it waits for the writer thread.
+  int sync() override
+  {
+    bool ok = drain();
+    wait_for_writer_thread();
+    return ok ? 0 : -1;
+  }
+
+private:
+  FLUSH_MODE mode;
+  unsigned long long max_bytes; // 0 = unlimited
+  unsigned long long total_written = 0;
+  std::vector<char> buffer;
+
+  // Async mode only
+  std::unique_ptr<OUTPUT_RING> ring;
+  std::thread writer_thread;
+  std::atomic<bool> stopping{false};
+  static inline OUTPUT_WRITER *active_writer = nullptr;
+
+  void run_writer_thread()
+  {
+    int idle_rounds = 0;
+    while (true)
+    {
+      if (ring->pop_to_stdout())
+      {
+        idle_rounds = 0;
+        continue;
+      }
+      if (stopping.load(std::memory_order_acquire))
+      {
+        ring->pop_to_stdout(); // bytes pushed just before the stop request
+        return;
+      }
+      // Stay responsive while output is flowing, back off while it is not
+      if (++idle_rounds < 64)
+        std::this_thread::yield();
+      else
+        std::this_thread::sleep_for(std::chrono::microseconds(200));
+    }
+  }
+
+  void wait_for_writer_thread()
+  {
+    if (!ring || stopping.load(std::memory_order_acquire))
+      return;
+    while (!ring->empty())
+      std::this_thread::yield();
+  }
+
+  void stop_writer_thread()
+  {
+    drain();
+    stopping.store(true, std::memory_order_release);
+    if (writer_thread.joinable())
+      writer_thread.join();
+    ring.reset(); // later output (std::cout's exit flush) is written directly
+  }
+
+  // Writes bytes to stdout, or hands them to the writer thread in async mode
+  bool emit(const char *bytes, size_t count)
+  {
+    if (ring)
+    {
+      ring->push(bytes, count);
+      return true;
+    }
+    return std::fwrite(bytes, 1, count, stdout) == count;
+  }
+
+  // Writes everything buffered so far to stdout
+  bool drain()
+  {
+    size_t pending = pptr() - pbase();
+    if (pending == 0)
+      return true;
+
+    bool over_limit = max_bytes && total_written + pending > max_bytes;
+    if (over_limit)
+      pending = max_bytes - total_written;
+
+    bool ok = emit(pbase(), pending);
+    total_written += pending;
+    setp(buffer.data(), buffer.data() + buffer.size());
+
+    if (over_limit)
+    {
+      wait_for_writer_thread();
+      std::cerr << "\nRuntime Error: Output limit of " << max_bytes << " bytes exceeded." << std::endl;
+      std::_Exit(1); // exit() would flush std::cout back into this buffer
+    }
+    return ok;
+  }
+};
+
+#endif
@@ -0,0 +1,563 @@
+#ifndef __PARALLEL_LOOP_H
+#define __PARALLEL_LOOP_H
+
+#include "ast.hpp"
+#include <iostream>
+#include <set>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// parallel for (int i = a; i < b; i++) reduce(+: total, *: scale) { ... }
+//
+// A counted loop whose iterations may run at the same time, on the threads
+// of the WORK_STEALING_POOL. TYPE_CHECKER only accepts it when no iteration
+// can see another's writes (see PARALLEL_CHECK below): the body writes its
+// own local variables, the reduction variables (only through +=, -=, ++,
+// -- for '+' and *= for '*', and never reads them), and arrays declared
+// outside the loop only at a[i], i being the counter, so each element has
+// one writer. The interpreter cuts the iterations into chunks that depend
+// on the iteration count alone; every chunk counts its own partial result
+// of each reduction, starting from 0, "" or 1, and buffers what it prints.
+// The partials are then added (or multiplied) into the variables and the
+// output written in chunk order, so the program prints and computes the
+// same whatever the number of threads.
+struct PARALLEL_LOOP
+{
+  struct REDUCTION
+  {
+    enum type op; // TOKEN_PLUS or TOKEN_ASTERISK
+    std::string name;
+  };
+  std::vector<REDUCTION> reductions; // from reduce(...), set by PARSER
+
+  // Set by PARALLEL_CHECK
+  std::string counter;
+  int step = 0;                       // +1 or -1
+  std::set<std::string> written;      // outer arrays the body writes at a[i]
+
+  const REDUCTION *reduction(const std::string &name) const
+  {
+    for (auto &r : reductions)
+      if (r.name == name)
+        return &r;
+    return nullptr;
+  }
+};
+
+// Verifies the body of a parallel loop (and the bound it is compared
+// with), and every user function it calls, by walking them once the rest of
+// the loop has been type-checked. Names declared inside the body are its
+// own; any other name is shared by all iterations. Rejected with a
+// Semantic Error:
+//   - assigning a shared variable or the counter; using a reduction
+//     variable any other way than its operator's compound assignment
+//   - writing an element of a shared array other than a[i] (a[i][j] and
+//     a[i].push(x) are a[i]'s), or using such an array as a whole, apart
+//     from a.length
+//   - setting a field, except on a local struct; calling a class method,
+//     'new' for a class, super
+//   - reading input, break out of the loop, return, a nested parallel loop
+//   - calling a function that writes any global or field, or reads a
+//     variable the loop writes, under the same rules
+class PARALLEL_CHECK : public AST_VISITOR
+{
+public:
+  PARALLEL_CHECK(FOR_STATEMENT *stmt, const std::unordered_map<std::string, FUNCTION_DECLARATION_STATEMENT *> &functions,
+                 const std::set<std::string> &struct_names, const std::set<std::string> &method_names)
+      : loop(stmt), plan(*stmt->parallel), functions(functions), struct_names(struct_names), method_names(method_names) {}
+
+  // Fills in the plan; exits on the first thing that is not allowed
+  void check()
+  {
+    check_shape();
+    scopes.push_back({});
+    walk(static_cast<BINARY_EXPRESSION *>(loop->condition)->right_operand);
+    walk(loop->body);
+    scopes.pop_back();
+
+    for (auto &name : whole_uses)
+      if (plan.written.count(name))
+        fail("writes " + name + "[" + plan.counter + "] but also uses '" + name +
+             "' as a whole; only " + name + "[" + plan.counter + "] and " + name + ".length are allowed.");
+
+    // Functions are checked once every write of the loop is known
+    std::vector<std::string> calls;
+    calls.swap(called);
+    for (auto &name : calls)
+      check_function(name, "");
+  }
+
+private:
+  FOR_STATEMENT *loop;
+  PARALLEL_LOOP &plan;
+  const std::unordered_map<std::string, FUNCTION_DECLARATION_STATEMENT *> &functions;
+  const std::set<std::string> &struct_names, &method_names;
+
+  std::vector<std::unordered_map<std::string, std::string>> scopes; // local name -> declared type
+  std::string caller;      // "" in the loop, else "calls 'f', which " for the function being walked
+  int loop_depth = 0;      // loops inside the walked code, for break
+  std::set<std::string> whole_uses, checked;
+  std::vector<std::string> called;
+
+  void fail(const std::string &message)
+  {
+    std::cerr << "Semantic Error: Parallel loop " << caller << message << std::endl;
+    exit(1);
+  }
+
+  void walk(EXPRESSION *expr)
+  {
+    if (expr)
+      expr->accept(this);
+  }
+  void walk(STATEMENT *stmt)
+  {
+    if (stmt)
+      stmt->accept(this);
+  }
+
+  bool in_function() const { return !caller.empty(); }
+
+  bool is_local(const std::string &name) const
+  {
+    for (auto &scope : scopes)
+      if (scope.count(name))
+        return true;
+    return false;
+  }
+
+  void declare(const std::string &name, const std::string &type) { scopes.back()[name] = type; }
+
+  bool is_counter(EXPRESSION *expr) const
+  {
+    return !in_function() && expr->kind == NODE_VARIABLE_EXPRESSION &&
+           static_cast<VARIABLE_EXPRESSION *>(expr)->name.VALUE == plan.counter && !is_local(plan.counter);
+  }
+
+  // A local variable of a struct type: struct values are copied, never shared
+  bool is_local_struct(EXPRESSION *expr) const
+  {
+    if (expr->kind != NODE_VARIABLE_EXPRESSION)
+      return false;
+    const std::string &name = static_cast<VARIABLE_EXPRESSION *>(expr)->name.VALUE;
+    for (int i = scopes.size() - 1; i >= 0; i--)
+    {
+      auto found = scopes[i].find(name);
+      if (found != scopes[i].end())
+        return struct_names.count(found->second) > 0;
+    }
+    return false;
+  }
+
+  // for (int i = a; i < b; i++), i++ / i += 1 counting towards b, or
+  // i-- / i -= 1 counting down to it
+  void check_shape()
+  {
+    auto declaration = static_cast<VARIABLE_DECLARATION_STATEMENT *>(loop->initializer);
+    if (!declaration || declaration->kind != NODE_VARIABLE_DECLARATION_STATEMENT || !declaration->initializer_expression ||
+        (declaration->type_token.VALUE != "int" && declaration->type_token.VALUE != "short" && declaration->type_token.VALUE != "long"))
+      fail("must start by declaring an integer counter, as in parallel for (int i = 0; i < n; i++).");
+    plan.counter = declaration->name_token.VALUE;
+
+    auto condition = static_cast<BINARY_EXPRESSION *>(loop->condition);
+    if (!condition || condition->kind != NODE_BINARY_EXPRESSION || !is_counter(condition->left_operand))
+      fail("must compare its counter with a bound, as in i < n.");
+    enum type op = condition->operator_token.TYPE;
+    plan.step = unit_step(loop->increment);
+    bool counts_up = op == TOKEN_LESS_THAN || op == TOKEN_LESS_EQUAL;
+    bool counts_down = op == TOKEN_GREATER_THAN || op == TOKEN_GREATER_EQUAL;
+    if ((plan.step != 1 || !counts_up) && (plan.step != -1 || !counts_down))
+      fail("must step its counter by one towards the bound: i++ with < or <=, i-- with > or >=.");
+
+    for (auto &r : plan.reductions)
+      if (r.name == plan.counter)
+        fail("cannot reduce into its counter '" + plan.counter + "'.");
+  }
+
+  int unit_step(EXPRESSION *increment) const
+  {
+    if (!increment)
+      return 0;
+    if (increment->kind == NODE_INCREMENT_EXPRESSION)
+    {
+      auto inc = static_cast<INCREMENT_EXPRESSION *>(increment);
+      if (!is_counter(inc->variable))
+        return 0;
+      return inc->operator_token.TYPE == TOKEN_INCREMENT ? 1 : -1;
+    }
+    if (increment->kind == NODE_COMPOUND_ASSIGNMENT_EXPRESSION)
+    {
+      auto compound = static_cast<COMPOUND_ASSIGNMENT_EXPRESSION *>(increment);
+      if (!is_counter(compound->target) || compound->value_expression->kind != NODE_LITERAL_EXPRESSION ||
+          static_cast<LITERAL_EXPRESSION *>(compound->value_expression)->token.VALUE != "1")
+        return 0;
+      return compound->operator_token.TYPE == TOKEN_PLUS ? 1 : compound->operator_token.TYPE == TOKEN_MINUS ? -1 : 0;
+    }
+    return 0;
+  }
+
+  // The body (or a function) walked for the named function, at most once
+  void check_function(const std::string &name, const std::string &via)
+  {
+    if (!checked.insert(name).second)
+      return;
+    FUNCTION_DECLARATION_STATEMENT *func = functions.at(name);
+    std::string outer_caller = caller;
+    std::vector<std::unordered_map<std::string, std::string>> outer_scopes;
+    outer_scopes.swap(scopes);
+    int outer_depth = loop_depth;
+
+    caller = via + "calls '" + name + "', which ";
+    loop_depth = 0;
+    scopes.push_back({});
+    for (auto &p : func->parameters)
+      declare(p.name_token.VALUE, p.type_token.VALUE);
+    walk(func->body_block);
+
+    std::vector<std::string> calls;
+    calls.swap(called);
+    for (auto &callee : calls)
+      check_function(callee, caller);
+
+    scopes.swap(outer_scopes);
+    caller = outer_caller;
+    loop_depth = outer_depth;
+  }
+
+  void note_call(const std::string &name) { called.push_back(name); }
+
+  // x = v, x += v, x++ and the like on a plain name
+  void note_assignment(const std::string &name, enum type op)
+  {
+    if (is_local(name))
+      return;
+    if (in_function())
+      fail("writes global '" + name + "'.");
+    if (name == plan.counter)
+      fail("changes its counter '" + name + "'.");
+    if (const PARALLEL_LOOP::REDUCTION *r = plan.reduction(name))
+    {
+      if (r->op == TOKEN_PLUS ? (op == TOKEN_PLUS || op == TOKEN_MINUS) : op == TOKEN_ASTERISK)
+        return;
+      fail("uses reduction variable '" + name + "' other than with " + (r->op == TOKEN_PLUS ? "+=, -=, ++ or --." : "*="));
+    }
+    fail("assigns '" + name + "', which all iterations share; declare it inside the loop or list it in reduce(...).");
+  }
+
+  // A write to an element at any depth of the array 'array_expression'
+  // (a[k] = v, a[k][j] += v, a[k].push(v), ...): allowed on a local array,
+  // and on a shared one only when k, the first index, is the counter
+  void note_element_write(EXPRESSION *array_expression, EXPRESSION *index_expression, const std::string &what)
+  {
+    walk(index_expression);
+    EXPRESSION *base = array_expression, *first = index_expression;
+    while (base->kind == NODE_ARRAY_ACCESS_EXPRESSION)
+    {
+      auto access = static_cast<ARRAY_ACCESS_EXPRESSION *>(base);
+      first = access->index_expression;
+      walk(first);
+      base = access->array_expression;
+    }
+
+    if (base->kind == NODE_GET_EXPRESSION)
+    {
+      auto get_expr = static_cast<GET_EXPRESSION *>(base);
+      note_field_write(get_expr->object_expression, get_expr->member_name);
+      return;
+    }
+    if (base->kind != NODE_VARIABLE_EXPRESSION)
+    {
+      walk(base);
+      return;
+    }
+
+    const std::string &name = static_cast<VARIABLE_EXPRESSION *>(base)->name.VALUE;
+    if (is_local(name))
+      return;
+    if (in_function())
+      fail(what + " global '" + name + "'.");
+    if (plan.reduction(name))
+      fail("uses reduction variable '" + name + "' other than with its operator.");
+    if (!is_counter(first))
+      fail(what + " '" + name + "' at an index other than '" + plan.counter + "'; an iteration may only write its own " +
+           name + "[" + plan.counter + "].");
+    plan.written.insert(name);
+  }
+
+  // o.f = v, o.f += v and the like
+  void note_field_write(EXPRESSION *object, const Token &member)
+  {
+    if (!is_local_struct(object))
+      fail("sets field '" + member.VALUE + "' of a shared object.");
+  }
+
+  void note_target(EXPRESSION *target, enum type op)
+  {
+    if (target->kind == NODE_VARIABLE_EXPRESSION)
+      note_assignment(static_cast<VARIABLE_EXPRESSION *>(target)->name.VALUE, op);
+    else if (target->kind == NODE_ARRAY_ACCESS_EXPRESSION)
+    {
+      auto access = static_cast<ARRAY_ACCESS_EXPRESSION *>(target);
+      note_element_write(access->array_expression, access->index_expression, "writes");
+    }
+    else if (target->kind == NODE_GET_EXPRESSION)
+    {
+      auto get_expr = static_cast<GET_EXPRESSION *>(target);
+      note_field_write(get_expr->object_expression, get_expr->member_name);
+    }
+  }
+
+  // ==========================================
+  //          EXPRESSIONS
+  // ==========================================
+public:
+  void visit(LITERAL_EXPRESSION *expr) override {}
+
+  void visit(VARIABLE_EXPRESSION *expr) override
+  {
+    const std::string &name = expr->name.VALUE;
+    if (is_local(name))
+      return;
+    if (functions.count(name))
+    {
+      note_call(name); // map(f), filter(f), reduce(f, x)
+      return;
+    }
+    if (plan.reduction(name) || (in_function() && plan.written.count(name)))
+      fail("reads '" + name + "', which the loop writes.");
+    if (!in_function())
+      whole_uses.insert(name);
+  }
+
+  void visit(BINARY_EXPRESSION *expr) override
+  {
+    walk(expr->left_operand);
+    walk(expr->right_operand);
+  }
+
+  void visit(CONCAT_EXPRESSION *expr) override
+  {
+    for (auto part : expr->parts)
+      walk(part);
+  }
+
+  void visit(BITWISE_EXPRESSION *expr) override
+  {
+    walk(expr->left_operand);
+    walk(expr->right_operand);
+  }
+
+  void visit(LOGICAL_EXPRESSION *expr) override
+  {
+    walk(expr->left_operand);
+    walk(expr->right_operand);
+  }
+
+  void visit(UNARY_EXPRESSION *expr) override { walk(expr->right_operand); }
+
+  void visit(INCREMENT_EXPRESSION *expr) override { note_target(expr->variable, TOKEN_PLUS); }
+
+  void visit(COMPOUND_ASSIGNMENT_EXPRESSION *expr) override
+  {
+    note_target(expr->target, expr->operator_token.TYPE);
+    walk(expr->value_expression);
+  }
+
+  void visit(CALL_EXPRESSION *expr) override
+  {
+    if (expr->target == CALL_EXPRESSION::CALL_FUNCTION)
+    {
+      const std::string &name = static_cast<VARIABLE_EXPRESSION *>(expr->callee)->name.VALUE;
+      static const std::set<std::string> readers = {"read_line", "end_of_input", "lines", "read_ints",
+                                                    "read_floats", "read_int_column", "read_float_column"};
+      if (functions.count(name))
+        note_call(name);
+      else if (readers.count(name))
+        fail("reads input with " + name + "(); its iterations run in no fixed order.");
+    }
+    else if (expr->target == CALL_EXPRESSION::CALL_METHOD)
+    {
+      auto get_expr = static_cast<GET_EXPRESSION *>(expr->callee);
+      const std::string &member = get_expr->member_name.VALUE;
+      EXPRESSION *object = get_expr->object_expression;
+      if (method_names.count(member))
+        fail("calls method '" + member + "'; methods may change fields the iterations share.");
+      if (member == "push" || member == "remove")
+      {
+        if (object->kind == NODE_VARIABLE_EXPRESSION)
+        {
+          const std::string &name = static_cast<VARIABLE_EXPRESSION *>(object)->name.VALUE;
+          if (!is_local(name))
+            fail("calls " + member + "() on " + (in_function() ? "global '" : "shared '") + name + "'.");
+        }
+        else if (object->kind == NODE_ARRAY_ACCESS_EXPRESSION)
+        {
+          auto access = static_cast<ARRAY_ACCESS_EXPRESSION *>(object);
+          note_element_write(access->array_expression, access->index_expression, "calls " + member + "() on");
+        }
+        else if (object->kind == NODE_GET_EXPRESSION)
+          note_field_write(static_cast<GET_EXPRESSION *>(object)->object_expression, static_cast<GET_EXPRESSION *>(object)->member_name);
+        else
+          walk(object);
+      }
+      else
+        walk(object);
+    }
+    else
+      fail("calls super.");
+    for (auto arg : expr->arguments)
+      walk(arg);
+  }
+
+  void visit(INPUT_EXPRESSION *expr) override { fail("reads input; its iterations run in no fixed order."); }
+
+  void visit(ARRAY_LITERAL_EXPRESSION *expr) override
+  {
+    for (auto element : expr->elements)
+      walk(element);
+  }
+
+  void visit(ARRAY_ACCESS_EXPRESSION *expr) override
+  {
+    // a[i] of a shared array is this iteration's element
+    if (expr->array_expression->kind == NODE_VARIABLE_EXPRESSION && is_counter(expr->index_expression) &&
+        !plan.reduction(static_cast<VARIABLE_EXPRESSION *>(expr->array_expression)->name.VALUE))
+      return;
+    walk(expr->array_expression);
+    walk(expr->index_expression);
+  }
+
+  void visit(ARRAY_ASSIGNMENT_EXPRESSION *expr) override
+  {
+    note_element_write(expr->array_expression, expr->index_expression, "writes");
+    walk(expr->value_expression);
+  }
+
+  void visit(ASSIGNMENT_EXPRESSION *expr) override
+  {
+    note_assignment(expr->variable_name.VALUE, TOKEN_EQUALS);
+    walk(expr->value_expression);
+  }
+
+  void visit(NEW_EXPRESSION *expr) override
+  {
+    if (!struct_names.count(expr->class_name.VALUE))
+      fail("creates a '" + expr->class_name.VALUE + "' with new; constructors may change what the iterations share.");
+    for (auto arg : expr->arguments)
+      walk(arg);
+  }
+
+  void visit(SUPER_EXPRESSION *expr) override { fail("calls super."); }
+
+  void visit(GET_EXPRESSION *expr) override
+  {
+    // a.length stays put while the loop writes a[i]
+    if (expr->member_name.VALUE == "length" && expr->object_expression->kind == NODE_VARIABLE_EXPRESSION &&
+        !plan.reduction(static_cast<VARIABLE_EXPRESSION *>(expr->object_expression)->name.VALUE))
+      return;
+    walk(expr->object_expression);
+  }
+
+  void visit(SET_EXPRESSION *expr) override
+  {
+    note_field_write(expr->object_expression, expr->member_name);
+    walk(expr->object_expression);
+    walk(expr->value_expression);
+  }
+
+  // ==========================================
+  //          STATEMENTS
+  // ==========================================
+
+  void visit(EXPRESSION_STATEMENT *stmt) override { walk(stmt->expression); }
+  void visit(PRINT_STATEMENT *stmt) override { walk(stmt->expression); }
+
+  void visit(VARIABLE_DECLARATION_STATEMENT *stmt) override
+  {
+    walk(stmt->initializer_expression);
+    declare(stmt->name_token.VALUE, stmt->type_token.VALUE);
+  }
+
+  void visit(BLOCK_STATEMENT *stmt) override
+  {
+    scopes.push_back({});
+    for (auto s : stmt->statements)
+      walk(s);
+    scopes.pop_back();
+  }
+
+  void visit(IF_STATEMENT *stmt) override
+  {
+    walk(stmt->condition_expression);
+    walk(stmt->then_branch_statement);
+    walk(stmt->else_branch_statement);
+  }
+
+  void visit(SWITCH_STATEMENT *stmt) override
+  {
+    walk(stmt->value);
+    for (auto &c : stmt->cases)
+    {
+      walk(c.condition);
+      scopes.push_back({});
+      for (auto s : c.statements)
+        walk(s);
+      scopes.pop_back();
+    }
+  }
+
+  void visit(WHILE_STATEMENT *stmt) override
+  {
+    walk(stmt->condition_expression);
+    loop_depth++;
+    walk(stmt->body_statement);
+    loop_depth--;
+  }
+
+  void visit(FOR_STATEMENT *stmt) override
+  {
+    if (stmt->parallel)
+      fail("contains another parallel loop.");
+    scopes.push_back({});
+    walk(stmt->initializer);
+    walk(stmt->condition);
+    walk(stmt->increment);
+    loop_depth++;
+    walk(stmt->body);
+    loop_depth--;
+    scopes.pop_back();
+  }
+
+  void visit(FOREACH_STATEMENT *stmt) override
+  {
+    walk(stmt->collection);
+    scopes.push_back({});
+    declare(stmt->name_token.VALUE, stmt->type_token.VALUE);
+    loop_depth++;
+    walk(stmt->body);
+    loop_depth--;
+    scopes.pop_back();
+  }
+
+  void visit(BREAK_STATEMENT *stmt) override
+  {
+    if (loop_depth == 0 && !in_function())
+      fail("uses 'break'; every iteration runs. Skip the rest of one with 'continue'.");
+  }
+
+  void visit(CONTINUE_STATEMENT *stmt) override {}
+
+  void visit(RETURN_STATEMENT *stmt) override
+  {
+    if (!in_function())
+      fail("uses 'return'.");
+    walk(stmt->value_expression);
+  }
+
+  void visit(FUNCTION_DECLARATION_STATEMENT *stmt) override { fail("declares function '" + stmt->name_token.VALUE + "'."); }
+  void visit(CLASS_DECLARATION_STATEMENT *stmt) override { fail("declares class '" + stmt->name_token.VALUE + "'."); }
+  void visit(STRUCT_DECLARATION_STATEMENT *stmt) override { fail("declares struct '" + stmt->name_token.VALUE + "'."); }
+};
+
+#endif
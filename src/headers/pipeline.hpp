@@ -0,0 +1,54 @@
+#ifndef __PIPELINE_H
+#define __PIPELINE_H
+
+#include "ast.hpp"
+#include <string>
+#include <vector>
+
+// A lazy pipeline: a source, then any number of stages, then an end.
+//
+//   range(1, 100).filter(is_prime).map(square).take(5).collect()
+//   scores.map(curve).reduce(add, 0)
+//   for (string line : lines("log.txt").filter(is_error)) { ... }
+//
+// Sources: an array (its elements), range(a, b[, step]) (the counts) and
+// lines() / lines(path) (the lines of stdin or a file, read one at a time,
+// sharing the reader of read_line()). Stages: map(f), filter(f), take(n),
+// where f names a user function of one parameter. Ends: collect() (an
+// array), reduce(f, initial) with f(accumulator, item), or a foreach loop.
+//
+// TYPE_CHECKER builds the plan; the stream calls themselves (range(),
+// lines(), map(), filter(), take()) only exist as parts of one, so
+// nothing runs until the end does. The interpreter then runs the whole
+// chain as a single loop over the source: each item goes through every
+// stage before the next one is read, no stage stores anything, and once a
+// take(n) has let n items through the source is not read any further.
+struct PIPELINE
+{
+  enum SOURCE
+  {
+    ARRAY,
+    RANGE,
+    LINES
+  } source;
+  // RANGE, LINES: the range(...) / lines(...) call. ARRAY: the first
+  // stage or the end, called on the array; its object expression is read
+  // from the node at run time, as OPTIMIZER may have replaced it.
+  CALL_EXPRESSION *origin;
+
+  struct STAGE
+  {
+    enum OP
+    {
+      MAP,
+      FILTER,
+      TAKE
+    } op;
+    CALL_EXPRESSION *call; // map(f) / filter(f): f; take(n): n
+  };
+  std::vector<STAGE> stages; // in the order items go through them
+
+  std::string item_type; // of the items leaving the last stage
+};
+
+#endif
@@ -0,0 +1,355 @@
+#ifndef __RANGE_ANALYSIS_H
+#define __RANGE_ANALYSIS_H
+
+#include "ast.hpp"
+#include <set>
+#include <string>
+#include <vector>
+
+// Bounds-check elimination. Runs after OPTIMIZER (which marks counted
+// loops) and before INTERPRETER::execute. In a loop
+//
+//   for (int i = 0; i < v.length; i++) { ... v[i] ... }
+//
+// every v[i] read or v[i] = x write is in bounds as long as:
+//   - i starts at a literal >= 0 and only ever steps up by one,
+//   - the body never assigns or redeclares i or v, nor sets a field named v
+//     (v may be a bare field name inside a method),
+//   - the body calls no user function, method or constructor, since those
+//     could reassign v (a global or a field) behind the loop's back.
+// Arrays never shrink in place (push and a[k] = x only grow them), so the
+// i < v.length checked at the top of the iteration still holds at the
+// access. Such accesses get in_bounds set; the interpreter skips their
+// index checks and keeps the full error path for all others.
+class RANGE_ANALYSIS : public AST_VISITOR
+{
+private:
+  // A loop being walked whose v[i] accesses may be in bounds
+  struct LOOP
+  {
+    std::string counter, array;
+    std::set<std::string> written; // names assigned or declared in the body
+    bool calls_out = false;        // the body runs code not visible here
+    std::vector<ARRAY_ACCESS_EXPRESSION *> reads;
+    std::vector<ARRAY_ASSIGNMENT_EXPRESSION *> writes;
+  };
+  std::vector<LOOP> loops; // innermost last; facts apply to all of them
+
+  std::set<std::string> user_methods, user_functions, struct_names;
+
+  void walk(EXPRESSION *expr)
+  {
+    if (expr)
+      expr->accept(this);
+  }
+  void walk(STATEMENT *stmt)
+  {
+    if (stmt)
+      stmt->accept(this);
+  }
+
+  void note_write(const std::string &name)
+  {
+    for (auto &loop : loops)
+      loop.written.insert(name);
+  }
+
+  void note_call()
+  {
+    for (auto &loop : loops)
+      loop.calls_out = true;
+  }
+
+  // x, o.f or a[k] as the target of ++, -- or a compound assignment
+  void note_target(EXPRESSION *target)
+  {
+    if (target->kind == NODE_VARIABLE_EXPRESSION)
+      note_write(static_cast<VARIABLE_EXPRESSION *>(target)->name.VALUE);
+    else
+    {
+      if (target->kind == NODE_GET_EXPRESSION)
+        note_write(static_cast<GET_EXPRESSION *>(target)->member_name.VALUE);
+      walk(target);
+    }
+  }
+
+  static bool is_variable(EXPRESSION *expr, const std::string &name)
+  {
+    return expr->kind == NODE_VARIABLE_EXPRESSION && static_cast<VARIABLE_EXPRESSION *>(expr)->name.VALUE == name;
+  }
+
+  // for (int i = <literal >= 0>; i < v.length; i++), with i and v filled in
+  static bool is_candidate(FOR_STATEMENT *stmt, std::string &counter, std::string &array)
+  {
+    if (stmt->counted_step != 1)
+      return false;
+    auto declaration = static_cast<VARIABLE_DECLARATION_STATEMENT *>(stmt->initializer);
+    EXPRESSION *start = declaration->initializer_expression;
+    if (!start || start->kind != NODE_LITERAL_EXPRESSION)
+      return false;
+    const Token &literal = static_cast<LITERAL_EXPRESSION *>(start)->token;
+    if (literal.TYPE != TOKEN_INT_LITERAL || literal.VALUE.empty() || literal.VALUE[0] == '-')
+      return false;
+
+    auto condition = static_cast<BINARY_EXPRESSION *>(stmt->condition);
+    if (condition->operator_token.TYPE != TOKEN_LESS_THAN || condition->right_operand->kind != NODE_GET_EXPRESSION)
+      return false;
+    auto length = static_cast<GET_EXPRESSION *>(condition->right_operand);
+    counter = declaration->name_token.VALUE;
+    array = static_cast<VARIABLE_EXPRESSION *>(length->object_expression)->name.VALUE;
+    return array != counter;
+  }
+
+  // v[i] with v and i plain names, as a read or a write target
+  void note_access(EXPRESSION *array_expression, EXPRESSION *index_expression, ARRAY_ACCESS_EXPRESSION *read, ARRAY_ASSIGNMENT_EXPRESSION *write)
+  {
+    for (auto &loop : loops)
+    {
+      if (!is_variable(array_expression, loop.array) || !is_variable(index_expression, loop.counter))
+        continue;
+      if (read)
+        loop.reads.push_back(read);
+      else
+        loop.writes.push_back(write);
+    }
+  }
+
+  // Calls that cannot reach user code: built-in functions, struct
+  // constructors and the array/string/map methods no class redefines
+  bool is_plain_call(CALL_EXPRESSION *expr)
+  {
+    if (expr->target == CALL_EXPRESSION::CALL_FUNCTION)
+    {
+      const std::string &name = static_cast<VARIABLE_EXPRESSION *>(expr->callee)->name.VALUE;
+      static const std::set<std::string> builtins = {"int", "float", "string"};
+      // Built-ins that a user function of the same name replaces
+      static const std::set<std::string> shadowable = {"sum", "min", "max", "dot", "matrix", "transpose", "matmul", "range",
+                                                       "lines", "read_line", "end_of_input", "read_ints", "read_floats",
+                                                       "read_int_column", "read_float_column"};
+      return builtins.count(name) || struct_names.count(name) || (shadowable.count(name) && !user_functions.count(name));
+    }
+    if (expr->target == CALL_EXPRESSION::CALL_METHOD)
+    {
+      const std::string &name = static_cast<GET_EXPRESSION *>(expr->callee)->member_name.VALUE;
+      static const std::set<std::string> value_methods = {"push", "slice", "find", "contains", "split",
+                                                          "size", "get", "remove", "keys", "values"};
+      return value_methods.count(name) && !user_methods.count(name);
+    }
+    return false;
+  }
+
+  // Function and method bodies run outside any loop they are declared in
+  void walk_function(FUNCTION_DECLARATION_STATEMENT *func)
+  {
+    std::vector<LOOP> enclosing;
+    enclosing.swap(loops);
+    walk(func->body_block);
+    loops.swap(enclosing);
+  }
+
+public:
+  void analyze(std::vector<STATEMENT *> &program)
+  {
+    for (auto stmt : program)
+    {
+      if (stmt->kind == NODE_CLASS_DECLARATION_STATEMENT)
+        for (auto method : static_cast<CLASS_DECLARATION_STATEMENT *>(stmt)->methods)
+          user_methods.insert(method->name_token.VALUE);
+      else if (stmt->kind == NODE_FUNCTION_DECLARATION_STATEMENT)
+        user_functions.insert(static_cast<FUNCTION_DECLARATION_STATEMENT *>(stmt)->name_token.VALUE);
+      else if (stmt->kind == NODE_STRUCT_DECLARATION_STATEMENT)
+        struct_names.insert(static_cast<STRUCT_DECLARATION_STATEMENT *>(stmt)->name_token.VALUE);
+    }
+    for (auto stmt : program)
+      walk(stmt);
+  }
+
+  // ==========================================
+  //          EXPRESSIONS
+  // ==========================================
+
+  void visit(LITERAL_EXPRESSION *expr) override {}
+  void visit(VARIABLE_EXPRESSION *expr) override {}
+
+  void visit(BINARY_EXPRESSION *expr) override
+  {
+    walk(expr->left_operand);
+    walk(expr->right_operand);
+  }
+
+  void visit(CONCAT_EXPRESSION *expr) override
+  {
+    for (auto part : expr->parts)
+      walk(part);
+  }
+
+  void visit(BITWISE_EXPRESSION *expr) override
+  {
+    walk(expr->left_operand);
+    walk(expr->right_operand);
+  }
+
+  void visit(LOGICAL_EXPRESSION *expr) override
+  {
+    walk(expr->left_operand);
+    walk(expr->right_operand);
+  }
+
+  void visit(UNARY_EXPRESSION *expr) override { walk(expr->right_operand); }
+
+  void visit(INCREMENT_EXPRESSION *expr) override { note_target(expr->variable); }
+
+  void visit(COMPOUND_ASSIGNMENT_EXPRESSION *expr) override
+  {
+    note_target(expr->target);
+    walk(expr->value_expression);
+  }
+
+  void visit(CALL_EXPRESSION *expr) override
+  {
+    if (!is_plain_call(expr))
+      note_call();
+    if (expr->target == CALL_EXPRESSION::CALL_METHOD)
+      walk(static_cast<GET_EXPRESSION *>(expr->callee)->object_expression);
+    for (auto arg : expr->arguments)
+      walk(arg);
+  }
+
+  void visit(INPUT_EXPRESSION *expr) override { walk(expr->prompt_expression); }
+
+  void visit(ARRAY_LITERAL_EXPRESSION *expr) override
+  {
+    for (auto element : expr->elements)
+      walk(element);
+  }
+
+  void visit(ARRAY_ACCESS_EXPRESSION *expr) override
+  {
+    note_access(expr->array_expression, expr->index_expression, expr, nullptr);
+    walk(expr->array_expression);
+    walk(expr->index_expression);
+  }
+
+  void visit(ARRAY_ASSIGNMENT_EXPRESSION *expr) override
+  {
+    note_access(expr->array_expression, expr->index_expression, nullptr, expr);
+    walk(expr->array_expression);
+    walk(expr->index_expression);
+    walk(expr->value_expression);
+  }
+
+  void visit(ASSIGNMENT_EXPRESSION *expr) override
+  {
+    note_write(expr->variable_name.VALUE);
+    walk(expr->value_expression);
+  }
+
+  void visit(NEW_EXPRESSION *expr) override
+  {
+    note_call(); // runs the constructor
+    for (auto arg : expr->arguments)
+      walk(arg);
+  }
+
+  void visit(SUPER_EXPRESSION *expr) override {}
+
+  void visit(GET_EXPRESSION *expr) override { walk(expr->object_expression); }
+
+  void visit(SET_EXPRESSION *expr) override
+  {
+    note_write(expr->member_name.VALUE);
+    walk(expr->object_expression);
+    walk(expr->value_expression);
+  }
+
+  // ==========================================
+  //          STATEMENTS
+  // ==========================================
+
+  void visit(EXPRESSION_STATEMENT *stmt) override { walk(stmt->expression); }
+  void visit(PRINT_STATEMENT *stmt) override { walk(stmt->expression); }
+
+  void visit(VARIABLE_DECLARATION_STATEMENT *stmt) override
+  {
+    walk(stmt->initializer_expression);
+    note_write(stmt->name_token.VALUE);
+  }
+
+  void visit(BLOCK_STATEMENT *stmt) override
+  {
+    for (auto s : stmt->statements)
+      walk(s);
+  }
+
+  void visit(IF_STATEMENT *stmt) override
+  {
+    walk(stmt->condition_expression);
+    walk(stmt->then_branch_statement);
+    walk(stmt->else_branch_statement);
+  }
+
+  void visit(SWITCH_STATEMENT *stmt) override
+  {
+    walk(stmt->value);
+    for (auto &c : stmt->cases)
+    {
+      walk(c.condition);
+      for (auto s : c.statements)
+        walk(s);
+    }
+  }
+
+  void visit(WHILE_STATEMENT *stmt) override
+  {
+    walk(stmt->condition_expression);
+    walk(stmt->body_statement);
+  }
+
+  void visit(FOR_STATEMENT *stmt) override
+  {
+    walk(stmt->initializer);
+    walk(stmt->condition);
+    walk(stmt->increment);
+
+    LOOP loop;
+    if (!is_candidate(stmt, loop.counter, loop.array))
+    {
+      walk(stmt->body);
+      return;
+    }
+    loops.push_back(loop);
+    walk(stmt->body);
+    loop = std::move(loops.back());
+    loops.pop_back();
+
+    if (loop.calls_out || loop.written.count(loop.counter) || loop.written.count(loop.array))
+      return;
+    for (auto read : loop.reads)
+      read->in_bounds = true;
+    for (auto write : loop.writes)
+      write->in_bounds = true;
+  }
+
+  void visit(FOREACH_STATEMENT *stmt) override
+  {
+    walk(stmt->collection);
+    note_write(stmt->name_token.VALUE);
+    walk(stmt->body);
+  }
+
+  void visit(BREAK_STATEMENT *stmt) override {}
+  void visit(CONTINUE_STATEMENT *stmt) override {}
+  void visit(RETURN_STATEMENT *stmt) override { walk(stmt->value_expression); }
+
+  void visit(FUNCTION_DECLARATION_STATEMENT *stmt) override { walk_function(stmt); }
+
+  void visit(CLASS_DECLARATION_STATEMENT *stmt) override
+  {
+    for (auto method : stmt->methods)
+      walk_function(method);
+  }
+
+  void visit(STRUCT_DECLARATION_STATEMENT *stmt) override {}
+};
+
+#endif
@@ -0,0 +1,255 @@
+#ifndef __RUNTIME_STRING_H
+#define __RUNTIME_STRING_H
+
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <cstddef>
+#include <cstring>
+#include <mutex>
+#include <new>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+// The string held by a RuntimeValue. Copying one is O(1) and never copies
+// characters:
+//   - up to INLINE_CAPACITY bytes are stored inside the value itself;
+//   - longer text lives in a refcounted heap buffer shared by all copies;
+//   - literals and short identifier-like text ("north", "user_id") are
+//     interned: one buffer per distinct text, never freed and never
+//     refcounted, so two interned strings are equal exactly when they point
+//     to the same buffer.
+// Values are immutable. append() only writes into a buffer that nothing
+// else shares; otherwise it copies into a new one with room to grow, so
+// s += piece in a loop stays amortized O(1).
+class RUNTIME_STRING
+{
+public:
+  static constexpr size_t INLINE_CAPACITY = 22;
+  static constexpr size_t MAX_INTERNED_LENGTH = 32;
+  static constexpr size_t MAX_INTERNED_STRINGS = 1 << 16; // runtime-built text stops being interned past this
+
+  RUNTIME_STRING() { set_inline(nullptr, 0); }
+  RUNTIME_STRING(const char *text) : RUNTIME_STRING(std::string_view(text)) {}
+  RUNTIME_STRING(const std::string &text) : RUNTIME_STRING(std::string_view(text)) {}
+  RUNTIME_STRING(std::string_view text)
+  {
+    BUFFER *interned = looks_like_identifier(text) ? intern_buffer(text, false) : nullptr;
+    if (interned)
+      set_heap(interned);
+    else if (text.size() <= INLINE_CAPACITY)
+      set_inline(text.data(), text.size());
+    else
+      set_heap(BUFFER::create(text, text.size()));
+  }
+
+  // Always interned, whatever the text (string literals)
+  static RUNTIME_STRING intern(std::string_view text)
+  {
+    RUNTIME_STRING s;
+    s.set_heap(intern_buffer(text, true));
+    return s;
+  }
+
+  RUNTIME_STRING(const RUNTIME_STRING &other) : storage(other.storage), inline_size(other.inline_size) { retain(); }
+  RUNTIME_STRING(RUNTIME_STRING &&other) noexcept : storage(other.storage), inline_size(other.inline_size) { other.set_inline(nullptr, 0); }
+  RUNTIME_STRING &operator=(const RUNTIME_STRING &other)
+  {
+    if (this != &other)
+    {
+      other.retain();
+      release();
+      storage = other.storage;
+      inline_size = other.inline_size;
+    }
+    return *this;
+  }
+  RUNTIME_STRING &operator=(RUNTIME_STRING &&other) noexcept
+  {
+    if (this != &other)
+    {
+      release();
+      storage = other.storage;
+      inline_size = other.inline_size;
+      other.set_inline(nullptr, 0);
+    }
+    return *this;
+  }
+  ~RUNTIME_STRING() { release(); }
+
+  const char *data() const { return is_inline() ? storage.chars : storage.heap->data; }
+  size_t size() const { return is_inline() ? inline_size : storage.heap->size; }
+  size_t length() const { return size(); }
+  bool empty() const { return size() == 0; }
+  char operator[](size_t i) const { return data()[i]; }
+  std::string_view view() const { return std::string_view(data(), size()); }
+  operator std::string_view() const { return view(); }
+  std::string str() const { return std::string(data(), size()); }
+  bool is_interned() const { return !is_inline() && storage.heap->interned; }
+
+  // std::hash of the text; an interned string's is worked out once, when
+  // it is interned (map<string, V> keys)
+  size_t hash() const { return is_interned() ? storage.heap->hash : std::hash<std::string_view>()(view()); }
+
+  RUNTIME_STRING substr(size_t pos, size_t count) const { return RUNTIME_STRING(view().substr(pos, count)); }
+
+  // Makes room for 'total' bytes ahead of a series of appends
+  void reserve(size_t total)
+  {
+    if (total > INLINE_CAPACITY && !(owns_heap() && storage.heap->capacity >= total))
+      reallocate(total);
+  }
+
+  void append(std::string_view more)
+  {
+    size_t old_size = size();
+    size_t new_size = old_size + more.size();
+    if (is_inline() && new_size <= INLINE_CAPACITY)
+    {
+      std::memcpy(storage.chars + old_size, more.data(), more.size());
+      storage.chars[new_size] = '\0';
+      inline_size = (unsigned char)new_size;
+      return;
+    }
+    if (!(owns_heap() && storage.heap->capacity >= new_size))
+      reallocate(std::max(new_size, 2 * old_size));
+    std::memcpy(storage.heap->data + old_size, more.data(), more.size());
+    storage.heap->size = new_size;
+    storage.heap->data[new_size] = '\0';
+  }
+
+  // Interned strings compare by address, everything else by content
+  bool operator==(const RUNTIME_STRING &other) const
+  {
+    if (!is_inline() && !other.is_inline())
+    {
+      if (storage.heap == other.storage.heap)
+        return true;
+      if (storage.heap->interned && other.storage.heap->interned)
+        return false;
+    }
+    return view() == other.view();
+  }
+  bool operator!=(const RUNTIME_STRING &other) const { return !(*this == other); }
+
+  friend std::ostream &operator<<(std::ostream &out, const RUNTIME_STRING &s) { return out.write(s.data(), s.size()); }
+
+private:
+  struct BUFFER
+  {
+    std::atomic<size_t> refs;
+    size_t size;
+    size_t capacity;
+    bool interned;
+    size_t hash; // interned buffers only
+    char data[1]; // capacity + 1 bytes, nul-terminated
+
+    static BUFFER *create(std::string_view text, size_t capacity)
+    {
+      void *memory = ::operator new(offsetof(BUFFER, data) + capacity + 1);
+      BUFFER *buffer = static_cast<BUFFER *>(memory);
+      new (&buffer->refs) std::atomic<size_t>(1);
+      buffer->size = text.size();
+      buffer->capacity = capacity;
+      buffer->interned = false;
+      std::memcpy(buffer->data, text.data(), text.size());
+      buffer->data[text.size()] = '\0';
+      return buffer;
+    }
+  };
+
+  static constexpr unsigned char ON_HEAP = 0xFF;
+
+  union STORAGE
+  {
+    BUFFER *heap;
+    char chars[INLINE_CAPACITY + 1];
+  } storage;
+  unsigned char inline_size; // ON_HEAP when the text is in storage.heap
+
+  bool is_inline() const { return inline_size != ON_HEAP; }
+  bool owns_heap() const { return !is_inline() && !storage.heap->interned && storage.heap->refs.load(std::memory_order_acquire) == 1; }
+
+  void set_inline(const char *text, size_t n)
+  {
+    if (n)
+      std::memcpy(storage.chars, text, n);
+    storage.chars[n] = '\0';
+    inline_size = (unsigned char)n;
+  }
+
+  void set_heap(BUFFER *buffer)
+  {
+    storage.heap = buffer;
+    inline_size = ON_HEAP;
+  }
+
+  void retain() const
+  {
+    if (!is_inline() && !storage.heap->interned)
+      storage.heap->refs.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  void release()
+  {
+    if (is_inline() || storage.heap->interned)
+      return;
+    if (storage.heap->refs.fetch_sub(1, std::memory_order_acq_rel) == 1)
+    {
+      storage.heap->refs.~atomic();
+      ::operator delete(storage.heap);
+    }
+  }
+
+  // Moves the text into a private heap buffer of the given capacity
+  void reallocate(size_t capacity)
+  {
+    BUFFER *buffer = BUFFER::create(view(), capacity);
+    release();
+    set_heap(buffer);
+  }
+
+  static bool looks_like_identifier(std::string_view text)
+  {
+    if (text.empty() || text.size() > MAX_INTERNED_LENGTH || !(std::isalpha((unsigned char)text[0]) || text[0] == '_'))
+      return false;
+    for (char c : text)
+      if (!(std::isalnum((unsigned char)c) || c == '_'))
+        return false;
+    return true;
+  }
+
+  struct INTERN_TABLE
+  {
+    std::mutex lock;
+    std::unordered_map<std::string_view, BUFFER *> buffers; // keys view the buffers' own text
+  };
+
+  static INTERN_TABLE &table()
+  {
+    static INTERN_TABLE *instance = new INTERN_TABLE(); // outlives every static RUNTIME_STRING
+    return *instance;
+  }
+
+  // The shared buffer for 'text'. A new entry is only added when 'always'
+  // is set or the table is below MAX_INTERNED_STRINGS (nullptr otherwise).
+  static BUFFER *intern_buffer(std::string_view text, bool always)
+  {
+    INTERN_TABLE &t = table();
+    std::lock_guard<std::mutex> guard(t.lock);
+    auto found = t.buffers.find(text);
+    if (found != t.buffers.end())
+      return found->second;
+    if (!always && t.buffers.size() >= MAX_INTERNED_STRINGS)
+      return nullptr;
+    BUFFER *buffer = BUFFER::create(text, text.size());
+    buffer->interned = true;
+    buffer->hash = std::hash<std::string_view>()(text);
+    t.buffers.emplace(std::string_view(buffer->data, buffer->size), buffer);
+    return buffer;
+  }
+};
+
+#endif
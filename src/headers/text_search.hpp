@@ -0,0 +1,79 @@
+#ifndef __TEXT_SEARCH_H
+#define __TEXT_SEARCH_H
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <cstring>
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+// Substring search behind the string methods find(), contains() and
+// split(). With SSE2, 16 candidate positions are tested at once: a position
+// is only compared in full when both the first and the last byte of the
+// needle match there. Single bytes go through memchr; other builds use
+// std::string_view::find.
+class TEXT_SEARCH
+{
+public:
+  static constexpr size_t NOT_FOUND = std::string_view::npos;
+
+  // First position >= from where needle occurs in text, or NOT_FOUND
+  static size_t find(std::string_view text, std::string_view needle, size_t from = 0)
+  {
+    if (from > text.size() || needle.size() > text.size() - from)
+      return NOT_FOUND;
+    if (needle.empty())
+      return from;
+    if (needle.size() == 1)
+    {
+      const void *hit = std::memchr(text.data() + from, needle[0], text.size() - from);
+      return hit ? static_cast<const char *>(hit) - text.data() : NOT_FOUND;
+    }
+
+#if defined(__SSE2__)
+    const char *data = text.data();
+    size_t k = needle.size();
+    __m128i first = _mm_set1_epi8(needle[0]);
+    __m128i last = _mm_set1_epi8(needle[k - 1]);
+    size_t i = from;
+    // Both 16-byte loads (at i and at i + k - 1) stay inside the text
+    for (; i + k - 1 + 16 <= text.size(); i += 16)
+    {
+      __m128i block_first = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + i));
+      __m128i block_last = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + i + k - 1));
+      int candidates = _mm_movemask_epi8(_mm_and_si128(_mm_cmpeq_epi8(block_first, first), _mm_cmpeq_epi8(block_last, last)));
+      while (candidates)
+      {
+        size_t at = i + __builtin_ctz(candidates);
+        if (std::memcmp(data + at + 1, needle.data() + 1, k - 2) == 0)
+          return at;
+        candidates &= candidates - 1;
+      }
+    }
+    return text.find(needle, i);
+#else
+    return text.find(needle, from);
+#endif
+  }
+
+  // Pieces of text between occurrences of a non-empty separator
+  static std::vector<std::string_view> split(std::string_view text, std::string_view separator)
+  {
+    std::vector<std::string_view> parts;
+    size_t start = 0;
+    while (true)
+    {
+      size_t at = find(text, separator, start);
+      if (at == NOT_FOUND)
+        break;
+      parts.push_back(text.substr(start, at - start));
+      start = at + separator.size();
+    }
+    parts.push_back(text.substr(start));
+    return parts;
+  }
+};
+
+#endif
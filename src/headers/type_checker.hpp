@@ -2,6 +2,8 @@
 #define __TYPE_CHECKER_H
 
 #include "ast.hpp" // Corrected include
+#include "pipeline.hpp"
+#include "parallel_loop.hpp"
 #include <unordered_map>
 #include <vector>
 #include <iostream>
@@ -25,13 +27,23 @@ private:
   std::string current_class = "";
 
   std::vector<std::unordered_map<std::string, std::string>> scope_stack;
+  std::vector<std::set<std::string>> constant_stack; // 'const' names, parallel to scope_stack
   std::unordered_map<std::string, std::string> function_signatures;
+  std::unordered_map<std::string, FUNCTION_DECLARATION_STATEMENT *> function_declarations;
   std::string last_evaluated_type;
   std::string current_function_return_type;
   int loop_depth = 0; // To track if break/continue is valid
 
-  void enter_new_scope() { scope_stack.push_back({}); }
-  void exit_current_scope() { scope_stack.pop_back(); }
+  void enter_new_scope()
+  {
+    scope_stack.push_back({});
+    constant_stack.push_back({});
+  }
+  void exit_current_scope()
+  {
+    scope_stack.pop_back();
+    constant_stack.pop_back();
+  }
 
   void declare_variable(std::string name, std::string type)
   {
@@ -40,6 +52,7 @@ private:
       std::cerr << "Semantic Error: Variable '" << name << "' already declared in this scope." << std::endl;
       exit(1);
     }
+    check_map_keys(type);
     scope_stack.back()[name] = type;
   }
 
@@ -54,6 +67,23 @@ private:
     exit(1);
   }
 
+  // The optimizer propagates 'const' values, so they must never be written
+  void check_not_constant(std::string name)
+  {
+    for (int i = scope_stack.size() - 1; i >= 0; i--)
+    {
+      if (scope_stack[i].count(name))
+      {
+        if (constant_stack[i].count(name))
+        {
+          std::cerr << "Semantic Error: Cannot assign to constant '" << name << "'." << std::endl;
+          exit(1);
+        }
+        return;
+      }
+    }
+  }
+
   // --- TYPE PROMOTION HELPERS ---
 
   // Rank types by size/precision
@@ -76,6 +106,90 @@ private:
 
   bool is_numeric(std::string type) { return get_type_rank(type) > 0; }
 
+  // "int" for "int[]" and the like; "" unless the elements are numbers
+  std::string numeric_element(const std::string &type)
+  {
+    if (type.size() < 3 || type.compare(type.size() - 2, 2, "[]") != 0)
+      return "";
+    std::string element = type.substr(0, type.size() - 2);
+    return is_numeric(element) ? element : "";
+  }
+
+  // "float" for "float[][]" and the like; "" unless it is a numeric matrix
+  std::string matrix_element(const std::string &type)
+  {
+    if (type.size() < 5 || type.compare(type.size() - 4, 4, "[][]") != 0)
+      return "";
+    std::string element = type.substr(0, type.size() - 4);
+    return is_numeric(element) ? element : "";
+  }
+
+  // Fills in K and V for "map<K,V>"; false for any other type
+  bool map_types(const std::string &type, std::string &key, std::string &value)
+  {
+    if (type.compare(0, 4, "map<") != 0 || type.back() != '>')
+      return false;
+    int depth = 0;
+    for (size_t i = 4; i + 1 < type.size(); i++)
+    {
+      if (type[i] == '<')
+        depth++;
+      else if (type[i] == '>')
+        depth--;
+      else if (type[i] == ',' && depth == 0)
+      {
+        key = type.substr(4, i - 4);
+        value = type.substr(i + 1, type.size() - i - 2);
+        return true;
+      }
+    }
+    return false;
+  }
+
+  // Map keys are whole numbers or strings, in a declared type at any depth
+  void check_map_keys(const std::string &type)
+  {
+    std::string element = type;
+    while (element.size() > 2 && element.compare(element.size() - 2, 2, "[]") == 0)
+      element.resize(element.size() - 2);
+    std::string key, value;
+    if (!map_types(element, key, value))
+      return;
+    if (key != "string" && !(is_numeric(key) && get_type_rank(key) <= get_type_rank("long")))
+    {
+      std::cerr << "Type Error: Map key type must be an integer type or 'string', got '" << key << "'." << std::endl;
+      exit(1);
+    }
+    check_map_keys(value);
+  }
+
+  // Checks a key used with a map<K, V>
+  void check_map_key(const std::string &key_type, const std::string &used_type)
+  {
+    bool ok = used_type == "dynamic_input" ||
+              (key_type == "string" ? used_type == "string" : is_numeric(used_type) && get_type_rank(used_type) <= get_type_rank("long"));
+    if (!ok)
+    {
+      std::cerr << "Type Error: Map key must be '" << key_type << "', got '" << used_type << "'." << std::endl;
+      exit(1);
+    }
+  }
+
+  // Whole-array operators: a numeric array with another one, or with a
+  // number. Fills in the element type each side contributes.
+  bool is_elementwise(const std::string &left, const std::string &right, std::string &left_elem, std::string &right_elem)
+  {
+    left_elem = numeric_element(left);
+    right_elem = numeric_element(right);
+    if (left_elem.empty() && right_elem.empty())
+      return false;
+    if (left_elem.empty() && is_numeric(left))
+      left_elem = left;
+    if (right_elem.empty() && is_numeric(right))
+      right_elem = right;
+    return !left_elem.empty() && !right_elem.empty();
+  }
+
   // Logic: Can we assign 'source' to 'target'?
   // e.g., int -> float (OK), float -> int (Error)
   // CORRECTED: Allow assigning Int literals to Byte/Short/Long/Double
@@ -105,6 +219,14 @@ private:
     // [FIX] Allow float to double
     if (source == "float" && target == "double")
       return true;
+    // Numeric arrays convert like their elements (int[] literal -> byte[])
+    if (target.size() > 2 && source.size() > 2 && target.substr(target.size() - 2) == "[]" && source.substr(source.size() - 2) == "[]")
+    {
+      std::string target_elem = target.substr(0, target.size() - 2);
+      std::string source_elem = source.substr(0, source.size() - 2);
+      if (is_numeric(target_elem) && is_numeric(source_elem))
+        return can_assign(target_elem, source_elem);
+    }
 
     int t_rank = get_type_rank(target);
     int s_rank = get_type_rank(source);
@@ -140,9 +262,11 @@ public:
     // Pre-scan functions to allow recursive calls
     for (auto statement : program)
     {
-      if (auto func = dynamic_cast<FUNCTION_DECLARATION_STATEMENT *>(statement))
+      if (statement->kind == NODE_FUNCTION_DECLARATION_STATEMENT)
       {
+        auto func = static_cast<FUNCTION_DECLARATION_STATEMENT *>(statement);
         function_signatures[func->name_token.VALUE] = func->return_type_token.VALUE;
+        function_declarations[func->name_token.VALUE] = func;
       }
     }
     for (auto statement : program)
@@ -174,58 +298,79 @@ public:
       }
     }
     declare_variable(statement->name_token.VALUE, target_type);
+    if (statement->is_constant)
+      constant_stack.back().insert(statement->name_token.VALUE);
   }
 
   // CORRECTED: Allow String Concatenation with Numbers
-  void visit(BINARY_EXPRESSION *expr) override
+  // Result type of 'left OP right' for arithmetic/comparison operators
+  std::string check_binary_operation(Token op, std::string left, std::string right)
   {
-    expr->left_operand->accept(this);
-    std::string left = last_evaluated_type;
-    expr->right_operand->accept(this);
-    std::string right = last_evaluated_type;
+    // 0. WHOLE-ARRAY EQUALITY (a == b compares every element: one bool)
+    std::string left_elem, right_elem;
+    bool left_array = left.size() > 2 && left.compare(left.size() - 2, 2, "[]") == 0;
+    bool right_array = right.size() > 2 && right.compare(right.size() - 2, 2, "[]") == 0;
+    if ((op.TYPE == TOKEN_DOUBLE_EQUALS || op.TYPE == TOKEN_NOT_EQUALS) && (left_array || right_array))
+    {
+      if (!(left_array && right_array && (left == right || is_elementwise(left, right, left_elem, right_elem))))
+      {
+        std::cerr << "Type Error: Cannot compare '" << left << "' and '" << right << "'." << std::endl;
+        exit(1);
+      }
+      return "bool";
+    }
 
-    // 1. COMPARISON (==, !=, <, >, etc.)
-    if (expr->operator_token.TYPE >= TOKEN_DOUBLE_EQUALS && expr->operator_token.TYPE <= TOKEN_GREATER_EQUAL)
+    // 1. ELEMENT-WISE (int[] + int[], float[] * 2.0, a < b -> bool[])
+    if (is_elementwise(left, right, left_elem, right_elem))
+    {
+      if (op.TYPE >= TOKEN_DOUBLE_EQUALS && op.TYPE <= TOKEN_GREATER_EQUAL)
+        return "bool[]";
+      if (op.TYPE == TOKEN_PERCENT)
+      {
+        std::cerr << "Type Error: '%' is not defined on arrays. Got '" << left << "' and '" << right << "'." << std::endl;
+        exit(1);
+      }
+      return get_promoted_type(left_elem, right_elem) + "[]";
+    }
+
+    // 2. COMPARISON (==, !=, <, >, etc.)
+    if (op.TYPE >= TOKEN_DOUBLE_EQUALS && op.TYPE <= TOKEN_GREATER_EQUAL)
     {
       if (left != right && !(is_numeric(left) && is_numeric(right)))
       {
         std::cerr << "Type Error: Cannot compare '" << left << "' and '" << right << "'." << std::endl;
         exit(1);
       }
-      last_evaluated_type = "bool";
-      return;
+      return "bool";
     }
 
-    // 2. STRING CONCATENATION (+)
+    // 3. STRING CONCATENATION (+)
     // FIX: Allow 'string' + Any or Any + 'string'
-    if (expr->operator_token.TYPE == TOKEN_PLUS)
+    if (op.TYPE == TOKEN_PLUS)
     {
       if (left == "string" || right == "string")
-      {
-        last_evaluated_type = "string";
-        return;
-      }
+        return "string";
     }
 
-    // 3. NUMERIC MATH (+, -, *, /, %)
+    // 4. NUMERIC MATH (+, -, *, /, %)
     if (!is_numeric(left) || !is_numeric(right))
     {
-      std::cerr << "Type Error: Binary operation '" << expr->operator_token.VALUE
+      std::cerr << "Type Error: Binary operation '" << op.VALUE
                 << "' requires numeric operands. Got '" << left << "' and '" << right << "'." << std::endl;
       exit(1);
     }
 
     // Implicit Promotion (e.g., int + float -> float)
-    last_evaluated_type = get_promoted_type(left, right);
+    return get_promoted_type(left, right);
   }
 
-  // --- NEW: Bitwise Logic (&, |, ^, <<, >>) ---
-  void visit(BITWISE_EXPRESSION *expr) override
+  // Result type of 'left OP right' for bitwise operators
+  std::string check_bitwise_operation(std::string left, std::string right)
   {
-    expr->left_operand->accept(this);
-    std::string left = last_evaluated_type;
-    expr->right_operand->accept(this);
-    std::string right = last_evaluated_type;
+    // Element-wise on integer arrays (int[] & int[], long[] << 2)
+    std::string left_elem, right_elem;
+    if (is_elementwise(left, right, left_elem, right_elem))
+      return check_bitwise_operation(left_elem, right_elem) + "[]";
 
     // Bitwise ops generally only work on integers (byte, short, int, long)
     // Floats usually don't support bitwise ops directly in C-like languages
@@ -236,12 +381,65 @@ public:
     }
 
     // Promote result to the larger integer type
-    last_evaluated_type = get_promoted_type(left, right);
+    return get_promoted_type(left, right);
+  }
+
+  void visit(BINARY_EXPRESSION *expr) override
+  {
+    expr->left_operand->accept(this);
+    std::string left = last_evaluated_type;
+    expr->right_operand->accept(this);
+    std::string right = last_evaluated_type;
+    last_evaluated_type = check_binary_operation(expr->operator_token, left, right);
+    expr->is_string_concat = (last_evaluated_type == "string");
+  }
+
+  void visit(CONCAT_EXPRESSION *expr) override
+  {
+    for (auto part : expr->parts)
+      part->accept(this);
+    last_evaluated_type = "string";
+  }
+
+  // --- NEW: Bitwise Logic (&, |, ^, <<, >>) ---
+  void visit(BITWISE_EXPRESSION *expr) override
+  {
+    expr->left_operand->accept(this);
+    std::string left = last_evaluated_type;
+    expr->right_operand->accept(this);
+    std::string right = last_evaluated_type;
+    last_evaluated_type = check_bitwise_operation(left, right);
+  }
+
+  // Compound assignment: 'target = target OP value' must type check
+  void visit(COMPOUND_ASSIGNMENT_EXPRESSION *expr) override
+  {
+    if (expr->target->kind == NODE_VARIABLE_EXPRESSION)
+      check_not_constant(static_cast<VARIABLE_EXPRESSION *>(expr->target)->name.VALUE);
+    expr->target->accept(this);
+    std::string target_type = last_evaluated_type;
+    expr->value_expression->accept(this);
+    std::string value_type = last_evaluated_type;
+
+    std::string result_type;
+    if (expr->operator_token.TYPE >= TOKEN_BITWISE_AND && expr->operator_token.TYPE <= TOKEN_RIGHT_SHIFT)
+      result_type = check_bitwise_operation(target_type, value_type);
+    else
+      result_type = check_binary_operation(expr->operator_token, target_type, value_type);
+
+    if (!can_assign(target_type, result_type))
+    {
+      std::cerr << "Type Error: Cannot assign '" << result_type << "' to target of type '" << target_type << "'." << std::endl;
+      exit(1);
+    }
+    last_evaluated_type = target_type;
   }
 
   // --- NEW: Increment/Decrement (++, --) ---
   void visit(INCREMENT_EXPRESSION *expr) override
   {
+    if (expr->variable->kind == NODE_VARIABLE_EXPRESSION)
+      check_not_constant(static_cast<VARIABLE_EXPRESSION *>(expr->variable)->name.VALUE);
     expr->variable->accept(this);
     if (!is_numeric(last_evaluated_type))
     {
@@ -255,6 +453,23 @@ public:
     expr->array_expression->accept(this);
     std::string arr_type = last_evaluated_type;
 
+    // m[k] = v adds or replaces the entry for k
+    std::string key_type, value_type;
+    if (map_types(arr_type, key_type, value_type))
+    {
+      expr->index_expression->accept(this);
+      check_map_key(key_type, last_evaluated_type);
+      expr->value_expression->accept(this);
+      bool empty_array = last_evaluated_type == "array" && value_type.find("[]") != std::string::npos;
+      if (!empty_array && !can_assign(value_type, last_evaluated_type))
+      {
+        std::cerr << "Type Error: Cannot assign '" << last_evaluated_type << "' to map of '" << value_type << "'." << std::endl;
+        exit(1);
+      }
+      last_evaluated_type = value_type;
+      return;
+    }
+
     // Check if it's actually an array
     if (arr_type.length() < 3 || arr_type.substr(arr_type.length() - 2) != "[]")
     {
@@ -285,6 +500,7 @@ public:
   void visit(ASSIGNMENT_EXPRESSION *expr) override
   {
     std::string var_type = lookup_variable(expr->variable_name.VALUE);
+    check_not_constant(expr->variable_name.VALUE);
     expr->value_expression->accept(this);
     std::string val_type = last_evaluated_type;
 
@@ -430,6 +646,88 @@ public:
     stmt->body->accept(this);
     loop_depth--;
 
+    if (stmt->parallel)
+      check_parallel_loop(stmt);
+    exit_current_scope();
+  }
+
+  // --- PARALLEL LOOPS (see parallel_loop.hpp) ---
+  // Run with the loop's own scope still open, so the counter and every
+  // variable the loop can see are declared
+  void check_parallel_loop(FOR_STATEMENT *stmt)
+  {
+    PARALLEL_LOOP &plan = *stmt->parallel;
+    std::set<std::string> reduced;
+    for (auto &r : plan.reductions)
+    {
+      if (!reduced.insert(r.name).second)
+      {
+        std::cerr << "Semantic Error: '" << r.name << "' is listed twice in reduce(...)." << std::endl;
+        exit(1);
+      }
+      std::string type = lookup_variable(r.name);
+      check_not_constant(r.name);
+      if (!is_numeric(type) && !(type == "string" && r.op == TOKEN_PLUS))
+      {
+        std::cerr << "Type Error: Cannot reduce '" << r.name << "' of type '" << type << "' with '"
+                  << (r.op == TOKEN_PLUS ? "+" : "*") << "'." << std::endl;
+        exit(1);
+      }
+    }
+
+    std::set<std::string> struct_names, method_names;
+    for (auto &entry : class_registry)
+    {
+      if (entry.second.is_struct)
+        struct_names.insert(entry.first);
+      for (auto &method : entry.second.method_return_types)
+        method_names.insert(method.first);
+    }
+    PARALLEL_CHECK(stmt, function_declarations, struct_names, method_names).check();
+
+    for (auto &name : plan.written)
+    {
+      std::string type = lookup_variable(name);
+      if (type.size() < 3 || type.compare(type.size() - 2, 2, "[]") != 0)
+      {
+        std::cerr << "Semantic Error: Parallel loop writes into shared '" << name << "' of type '" << type
+                  << "'; only arrays can be written by several iterations at once." << std::endl;
+        exit(1);
+      }
+    }
+  }
+
+  void visit(FOREACH_STATEMENT *stmt) override
+  {
+    stream_allowed = stmt->collection;
+    stmt->collection->accept(this);
+    std::string collection = last_evaluated_type, value;
+    std::string element = stream_item(collection);
+    if (!element.empty())
+      stmt->pipeline = static_cast<CALL_EXPRESSION *>(stmt->collection)->pipeline;
+    else if (collection.size() > 2 && collection.compare(collection.size() - 2, 2, "[]") == 0)
+      element = collection.substr(0, collection.size() - 2);
+    else if (collection == "string")
+      element = "string";
+    else if (!map_types(collection, element, value))
+    {
+      std::cerr << "Type Error: Cannot iterate over '" << collection << "'." << std::endl;
+      exit(1);
+    }
+
+    std::string declared = stmt->type_token.VALUE;
+    if (!can_assign(declared, element))
+    {
+      std::cerr << "Type Error: Loop variable '" << stmt->name_token.VALUE << "' is '" << declared
+                << "' but the items are '" << element << "'." << std::endl;
+      exit(1);
+    }
+
+    enter_new_scope();
+    declare_variable(stmt->name_token.VALUE, declared);
+    loop_depth++;
+    stmt->body->accept(this);
+    loop_depth--;
     exit_current_scope();
   }
 
@@ -487,6 +785,7 @@ public:
         exit(1);
       }
     }
+    expr->element_type = first_elem_type;
     last_evaluated_type = first_elem_type + "[]";
   }
 
@@ -495,11 +794,24 @@ public:
     expr->array_expression->accept(this);
     std::string arr_type = last_evaluated_type;
     expr->index_expression->accept(this);
+    std::string key_type, value_type;
+    if (map_types(arr_type, key_type, value_type))
+    {
+      check_map_key(key_type, last_evaluated_type);
+      last_evaluated_type = value_type;
+      return;
+    }
     if (last_evaluated_type != "int")
     {
       std::cerr << "Type Error: Array index must be 'int'." << std::endl;
       exit(1);
     }
+    // s[i] is the character at i, as a string
+    if (arr_type == "string")
+    {
+      last_evaluated_type = "string";
+      return;
+    }
     if (arr_type.length() < 3 || arr_type.substr(arr_type.length() - 2) != "[]")
     {
       std::cerr << "Type Error: Not an array type." << std::endl;
@@ -508,10 +820,309 @@ public:
     last_evaluated_type = arr_type.substr(0, arr_type.length() - 2);
   }
 
+  // Checks one argument of a built-in method against the expected type
+  void check_method_argument(const std::string &method, CALL_EXPRESSION *expr, size_t index, const std::string &expected)
+  {
+    expr->arguments[index]->accept(this);
+    if (last_evaluated_type != expected)
+    {
+      std::cerr << "Type Error: " << method << "() argument " << (index + 1) << " must be '" << expected << "', got '" << last_evaluated_type << "'." << std::endl;
+      exit(1);
+    }
+  }
+
+  // Built-in methods of strings and arrays:
+  //   a.slice(start, end) / s.slice(start, end)  -> same type, [start, end)
+  //   s.find(needle[, from])                     -> int, -1 when absent
+  //   s.contains(needle)                         -> bool
+  //   s.split(separator)                         -> string[]
+  // False when obj_type has no such method
+  bool check_value_method(const std::string &obj_type, const std::string &method, CALL_EXPRESSION *expr)
+  {
+    bool is_array = obj_type.size() > 2 && obj_type.substr(obj_type.size() - 2) == "[]";
+    bool is_string = obj_type == "string";
+    size_t min_args, max_args;
+    if (method == "slice" && (is_array || is_string))
+      min_args = max_args = 2;
+    else if (method == "find" && is_string)
+      min_args = 1, max_args = 2;
+    else if ((method == "contains" || method == "split") && is_string)
+      min_args = max_args = 1;
+    else
+      return false;
+
+    if (expr->arguments.size() < min_args || expr->arguments.size() > max_args)
+    {
+      std::cerr << "Semantic Error: " << method << "() expects " << min_args;
+      if (max_args != min_args)
+        std::cerr << " or " << max_args;
+      std::cerr << " argument" << (max_args == 1 ? "" : "s") << "." << std::endl;
+      exit(1);
+    }
+
+    if (method == "slice")
+    {
+      check_method_argument(method, expr, 0, "int");
+      check_method_argument(method, expr, 1, "int");
+      last_evaluated_type = obj_type;
+    }
+    else
+    {
+      check_method_argument(method, expr, 0, "string");
+      if (expr->arguments.size() > 1)
+        check_method_argument(method, expr, 1, "int");
+      last_evaluated_type = method == "find" ? "int" : method == "contains" ? "bool" : "string[]";
+    }
+    return true;
+  }
+
+  // Methods of map<K, V>:
+  //   m.size()                  -> int
+  //   m.contains(k), m.remove(k) -> bool
+  //   m.get(k[, fallback])      -> V
+  //   m.keys(), m.values()      -> K[], V[]
+  // False when obj_type is not a map or has no such method
+  bool check_map_method(const std::string &obj_type, const std::string &method, CALL_EXPRESSION *expr)
+  {
+    std::string key_type, value_type;
+    if (!map_types(obj_type, key_type, value_type))
+      return false;
+    size_t min_args, max_args;
+    if (method == "size" || method == "keys" || method == "values")
+      min_args = max_args = 0;
+    else if (method == "contains" || method == "remove")
+      min_args = max_args = 1;
+    else if (method == "get")
+      min_args = 1, max_args = 2;
+    else
+      return false;
+
+    if (expr->arguments.size() < min_args || expr->arguments.size() > max_args)
+    {
+      std::cerr << "Semantic Error: " << method << "() expects " << min_args;
+      if (max_args != min_args)
+        std::cerr << " or " << max_args;
+      std::cerr << " argument" << (max_args == 1 ? "" : "s") << "." << std::endl;
+      exit(1);
+    }
+
+    if (!expr->arguments.empty())
+    {
+      expr->arguments[0]->accept(this);
+      check_map_key(key_type, last_evaluated_type);
+    }
+    if (expr->arguments.size() > 1)
+    {
+      expr->arguments[1]->accept(this);
+      if (!can_assign(value_type, last_evaluated_type))
+      {
+        std::cerr << "Type Error: get() fallback must be '" << value_type << "', got '" << last_evaluated_type << "'." << std::endl;
+        exit(1);
+      }
+    }
+
+    if (method == "size")
+      last_evaluated_type = "int";
+    else if (method == "keys")
+      last_evaluated_type = key_type + "[]";
+    else if (method == "values")
+      last_evaluated_type = value_type + "[]";
+    else if (method == "get")
+      last_evaluated_type = value_type;
+    else
+      last_evaluated_type = "bool";
+    return true;
+  }
+
+  // --- LAZY PIPELINES (see pipeline.hpp) ---
+  // A stream call has type "stream<T>", T being its item type. Streams are
+  // never stored: one may only be the object of another pipeline method or
+  // the collection of a foreach loop, which set stream_allowed to it first.
+  EXPRESSION *stream_allowed = nullptr;
+
+  static bool is_stream_method(const std::string &method)
+  {
+    return method == "map" || method == "filter" || method == "take" || method == "collect" || method == "reduce";
+  }
+
+  // T for "stream<T>", "" for any other type
+  static std::string stream_item(const std::string &type)
+  {
+    if (type.compare(0, 7, "stream<") != 0 || type.back() != '>')
+      return "";
+    return type.substr(7, type.size() - 8);
+  }
+
+  void check_stream_position(bool allowed, const std::string &name)
+  {
+    if (allowed)
+      return;
+    std::cerr << "Semantic Error: '" << name << "' is lazy: end the pipeline with collect() or reduce(), "
+              << "or loop over it with for (T x : ...)." << std::endl;
+    exit(1);
+  }
+
+  // range(end), range(start, end) or range(start, end, step), all whole
+  // numbers; the type of the values it counts through
+  std::string check_range(CALL_EXPRESSION *expr)
+  {
+    if (expr->arguments.empty() || expr->arguments.size() > 3)
+    {
+      std::cerr << "Semantic Error: 'range' expects (end), (start, end) or (start, end, step)." << std::endl;
+      exit(1);
+    }
+    std::string result = "int";
+    for (auto arg : expr->arguments)
+    {
+      arg->accept(this);
+      if (!is_numeric(last_evaluated_type) || get_type_rank(last_evaluated_type) > get_type_rank("long"))
+      {
+        std::cerr << "Type Error: 'range' bounds must be integers, got '" << last_evaluated_type << "'." << std::endl;
+        exit(1);
+      }
+      result = get_promoted_type(result, last_evaluated_type);
+    }
+    return result;
+  }
+
+  // Sources: range(...) and lines() / lines(path)
+  void check_stream_source(CALL_EXPRESSION *expr, const std::string &name, bool allowed)
+  {
+    check_stream_position(allowed, name);
+    auto plan = new PIPELINE();
+    plan->origin = expr;
+    if (name == "range")
+    {
+      plan->source = PIPELINE::RANGE;
+      plan->item_type = check_range(expr);
+    }
+    else
+    {
+      if (expr->arguments.size() > 1)
+      {
+        std::cerr << "Semantic Error: 'lines' expects at most 1 argument (a file path)." << std::endl;
+        exit(1);
+      }
+      if (!expr->arguments.empty())
+        check_method_argument(name, expr, 0, "string");
+      plan->source = PIPELINE::LINES;
+      plan->item_type = "string";
+    }
+    expr->pipeline = plan;
+    last_evaluated_type = "stream<" + plan->item_type + ">";
+  }
+
+  // The user function a map(), filter() or reduce() argument names, which
+  // must take 'count' parameters
+  FUNCTION_DECLARATION_STATEMENT *check_callback(const std::string &method, EXPRESSION *arg, size_t count)
+  {
+    FUNCTION_DECLARATION_STATEMENT *func = nullptr;
+    if (arg->kind == NODE_VARIABLE_EXPRESSION)
+    {
+      auto found = function_declarations.find(static_cast<VARIABLE_EXPRESSION *>(arg)->name.VALUE);
+      if (found != function_declarations.end())
+        func = found->second;
+    }
+    if (!func || func->parameters.size() != count)
+    {
+      std::cerr << "Semantic Error: " << method << "() expects the name of a function of " << count
+                << (count == 1 ? " parameter." : " parameters.") << std::endl;
+      exit(1);
+    }
+    return func;
+  }
+
+  void check_callback_parameter(const std::string &method, FUNCTION_DECLARATION_STATEMENT *func, size_t index, const std::string &type)
+  {
+    const std::string &expected = func->parameters[index].type_token.VALUE;
+    if (!can_assign(expected, type))
+    {
+      std::cerr << "Type Error: " << method << "() passes '" << type << "' to parameter '" << func->parameters[index].name_token.VALUE
+                << "' of '" << func->name_token.VALUE << "', which is '" << expected << "'." << std::endl;
+      exit(1);
+    }
+  }
+
+  // Pipeline methods of arrays and streams:
+  //   s.map(f), s.filter(f), s.take(n) -> stream (lazy)
+  //   s.collect()                      -> T[] (streams only)
+  //   s.reduce(f, initial)             -> what f returns
+  // False when obj_type is neither or method is not one of these. 'allowed'
+  // when expr may itself be a stream.
+  bool check_stream_method(const std::string &obj_type, const std::string &method, CALL_EXPRESSION *expr, bool allowed)
+  {
+    if (!is_stream_method(method))
+      return false;
+    EXPRESSION *object = static_cast<GET_EXPRESSION *>(expr->callee)->object_expression;
+    std::string item = stream_item(obj_type);
+    PIPELINE *plan;
+    if (!item.empty())
+      plan = new PIPELINE(*static_cast<CALL_EXPRESSION *>(object)->pipeline);
+    else if (obj_type.size() > 2 && obj_type.compare(obj_type.size() - 2, 2, "[]") == 0 && method != "collect")
+    {
+      item = obj_type.substr(0, obj_type.size() - 2);
+      plan = new PIPELINE();
+      plan->source = PIPELINE::ARRAY;
+      plan->origin = expr;
+    }
+    else
+      return false;
+
+    size_t expected = method == "collect" ? 0 : method == "reduce" ? 2 : 1;
+    if (expr->arguments.size() != expected)
+    {
+      std::cerr << "Semantic Error: " << method << "() expects " << expected << " argument" << (expected == 1 ? "" : "s") << "." << std::endl;
+      exit(1);
+    }
+
+    if (method == "map" || method == "filter")
+    {
+      FUNCTION_DECLARATION_STATEMENT *func = check_callback(method, expr->arguments[0], 1);
+      check_callback_parameter(method, func, 0, item);
+      const std::string &result = func->return_type_token.VALUE;
+      if (method == "filter" ? result != "bool" : result == "void")
+      {
+        std::cerr << "Type Error: " << method << "() function '" << func->name_token.VALUE << "' must return "
+                  << (method == "filter" ? "'bool'." : "a value.") << std::endl;
+        exit(1);
+      }
+      plan->stages.push_back({method == "map" ? PIPELINE::STAGE::MAP : PIPELINE::STAGE::FILTER, expr});
+      if (method == "map")
+        item = result;
+    }
+    else if (method == "take")
+    {
+      check_method_argument(method, expr, 0, "int");
+      plan->stages.push_back({PIPELINE::STAGE::TAKE, expr});
+    }
+    plan->item_type = item;
+    expr->pipeline = plan;
+
+    if (method == "collect")
+      last_evaluated_type = item + "[]";
+    else if (method == "reduce")
+    {
+      FUNCTION_DECLARATION_STATEMENT *func = check_callback(method, expr->arguments[0], 2);
+      expr->arguments[1]->accept(this);
+      check_callback_parameter(method, func, 0, last_evaluated_type);
+      check_callback_parameter(method, func, 1, item);
+      check_callback_parameter(method, func, 0, func->return_type_token.VALUE);
+      last_evaluated_type = func->return_type_token.VALUE;
+    }
+    else
+    {
+      check_stream_position(allowed, method);
+      last_evaluated_type = "stream<" + item + ">";
+    }
+    return true;
+  }
+
   void visit(CALL_EXPRESSION *expr) override
   {
-    if (auto v = dynamic_cast<VARIABLE_EXPRESSION *>(expr->callee))
+    bool stream_here = stream_allowed == expr; // read before the callee's object claims it
+    if (expr->target == CALL_EXPRESSION::CALL_FUNCTION)
     {
+      auto v = static_cast<VARIABLE_EXPRESSION *>(expr->callee);
       std::string name = v->name.VALUE;
       
       if (name == "int" || name == "float" || name == "string")
@@ -526,6 +1137,138 @@ public:
         return;
       }
 
+      // Line streaming built-ins: read from stdin, or from a file path. A
+      // user function of the same name takes precedence.
+      if ((name == "read_line" || name == "end_of_input") && !function_signatures.count(name))
+      {
+        if (expr->arguments.size() > 1)
+        {
+          std::cerr << "Semantic Error: '" << name << "' expects at most 1 argument (a file path)." << std::endl;
+          exit(1);
+        }
+        if (!expr->arguments.empty())
+        {
+          expr->arguments[0]->accept(this);
+          if (last_evaluated_type != "string")
+          {
+            std::cerr << "Type Error: '" << name << "' file path must be 'string', got '" << last_evaluated_type << "'." << std::endl;
+            exit(1);
+          }
+        }
+        last_evaluated_type = (name == "read_line") ? "string" : "bool";
+        return;
+      }
+
+      // Bulk numeric loading: read_ints(path?) / read_floats(path?) and
+      // read_int_column(path, column) / read_float_column(path, column),
+      // where column is a header name or a 0-based index. A user function
+      // of the same name takes precedence.
+      if ((name == "read_ints" || name == "read_floats" || name == "read_int_column" || name == "read_float_column") &&
+          !function_signatures.count(name))
+      {
+        bool by_column = (name == "read_int_column" || name == "read_float_column");
+        if (by_column ? expr->arguments.size() != 2 : expr->arguments.size() > 1)
+        {
+          std::cerr << "Semantic Error: '" << name << "' expects " << (by_column ? "(path, column)" : "at most 1 argument (a file path)") << "." << std::endl;
+          exit(1);
+        }
+        if (!expr->arguments.empty())
+        {
+          expr->arguments[0]->accept(this);
+          if (last_evaluated_type != "string")
+          {
+            std::cerr << "Type Error: '" << name << "' file path must be 'string', got '" << last_evaluated_type << "'." << std::endl;
+            exit(1);
+          }
+        }
+        if (by_column)
+        {
+          expr->arguments[1]->accept(this);
+          if (last_evaluated_type != "string" && last_evaluated_type != "int")
+          {
+            std::cerr << "Type Error: '" << name << "' column must be a header name or an 'int' index." << std::endl;
+            exit(1);
+          }
+        }
+        last_evaluated_type = (name == "read_ints" || name == "read_int_column") ? "int[]" : "float[]";
+        return;
+      }
+
+      // Reductions over numeric arrays: sum(a), min(a), max(a), dot(a, b).
+      // A user function of the same name takes precedence.
+      if ((name == "sum" || name == "min" || name == "max" || name == "dot") && !function_signatures.count(name))
+      {
+        size_t expected = (name == "dot") ? 2 : 1;
+        if (expr->arguments.size() != expected)
+        {
+          std::cerr << "Semantic Error: '" << name << "' expects " << (expected == 2 ? "2 arrays." : "1 array.") << std::endl;
+          exit(1);
+        }
+        std::string result;
+        for (auto arg : expr->arguments)
+        {
+          arg->accept(this);
+          std::string element = numeric_element(last_evaluated_type);
+          if (element.empty())
+          {
+            std::cerr << "Type Error: '" << name << "' expects a numeric array, got '" << last_evaluated_type << "'." << std::endl;
+            exit(1);
+          }
+          result = result.empty() ? element : get_promoted_type(result, element);
+        }
+        // Sums and dot products of small ints are at least 'int'
+        if (name != "min" && name != "max")
+          result = get_promoted_type(result, "int");
+        last_evaluated_type = result;
+        return;
+      }
+
+      // Matrices (rectangular numeric 2-D arrays): matrix(rows, columns)
+      // of zeros, transpose(m), matmul(a, b)
+      if ((name == "matrix" || name == "transpose" || name == "matmul") && !function_signatures.count(name))
+      {
+        size_t expected = (name == "transpose") ? 1 : 2;
+        if (expr->arguments.size() != expected)
+        {
+          std::cerr << "Semantic Error: '" << name << "' expects " << expected << (expected == 1 ? " argument." : " arguments.") << std::endl;
+          exit(1);
+        }
+        std::string result;
+        for (auto arg : expr->arguments)
+        {
+          arg->accept(this);
+          if (name == "matrix")
+          {
+            if (get_type_rank(last_evaluated_type) < 1 || get_type_rank(last_evaluated_type) > 4)
+            {
+              std::cerr << "Type Error: 'matrix' dimensions must be integers, got '" << last_evaluated_type << "'." << std::endl;
+              exit(1);
+            }
+            continue;
+          }
+          std::string element = matrix_element(last_evaluated_type);
+          if (element.empty())
+          {
+            std::cerr << "Type Error: '" << name << "' expects a numeric matrix (e.g. 'float[][]'), got '" << last_evaluated_type << "'." << std::endl;
+            exit(1);
+          }
+          result = result.empty() ? element : get_promoted_type(result, element);
+        }
+        if (name == "matrix")
+          result = "float";
+        else if (name == "matmul")
+          result = get_promoted_type(result, "int");
+        last_evaluated_type = result + "[][]";
+        return;
+      }
+
+      // Lazy pipeline sources: range(a, b[, step]), lines(path?)
+      if ((name == "range" || name == "lines") && !function_signatures.count(name))
+      {
+        check_stream_source(expr, name, stream_here);
+        return;
+      }
+
       if (class_registry.count(name))
       {
         ClassTypeInfo info = class_registry[name];
@@ -564,8 +1307,11 @@ public:
       std::cerr << "Semantic Error: Undefined function or struct constructor '" << name << "'." << std::endl;
       exit(1);
     }
-    else if (auto get_expr = dynamic_cast<GET_EXPRESSION *>(expr->callee))
+    else if (expr->target == CALL_EXPRESSION::CALL_METHOD)
     {
+      auto get_expr = static_cast<GET_EXPRESSION *>(expr->callee);
+      if (is_stream_method(get_expr->member_name.VALUE))
+        stream_allowed = get_expr->object_expression;
       get_expr->object_expression->accept(this);
       std::string obj_type = last_evaluated_type;
       
@@ -577,6 +1323,11 @@ public:
           obj_type = obj_type.substr(11);
       }
 
+      if (check_map_method(obj_type, get_expr->member_name.VALUE, expr) ||
+          check_value_method(obj_type, get_expr->member_name.VALUE, expr) ||
+          check_stream_method(obj_type, get_expr->member_name.VALUE, expr, stream_here))
+        return;
+
       if (obj_type.substr(obj_type.length() >= 2 ? obj_type.length() - 2 : 0) == "[]") {
           std::string method_name = get_expr->member_name.VALUE;
           if (method_name == "push") {
@@ -644,8 +1395,9 @@ public:
 
       last_evaluated_type = info.method_return_types[method_name];
     }
-    else if (auto super_expr = dynamic_cast<SUPER_EXPRESSION *>(expr->callee))
+    else if (expr->target == CALL_EXPRESSION::CALL_SUPER)
     {
+        auto super_expr = static_cast<SUPER_EXPRESSION *>(expr->callee);
         super_expr->accept(this);
         std::string obj_type = last_evaluated_type;
         if (obj_type.substr(0, 11) == "super_type:") {
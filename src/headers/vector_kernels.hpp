@@ -0,0 +1,367 @@
+#ifndef __VECTOR_KERNELS_H
+#define __VECTOR_KERNELS_H
+
+#include <cstddef>
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define NARUTO_AVX2_KERNELS 1
+#include <immintrin.h>
+#endif
+
+// Element-wise arithmetic and reductions on unboxed int64 / double
+// buffers, behind the vectorized loops (see VECTOR_LOOP) and the
+// whole-array operators. On x86 with GCC or Clang the AVX2 versions are
+// compiled in alongside the plain ones and picked at run time when the CPU
+// has AVX2, so the binary still runs on older machines.
+//   - Element-wise results are exactly those of the scalar operators: ints
+//     wrap, doubles are rounded per operation (no fused multiply-add).
+//   - AVX2 has no 64-bit integer multiply, divide or shift-by-lane with C
+//     semantics; those stay scalar.
+//   - Int reductions may add in any order, which wrapping addition allows.
+//     Double reductions (sum, dot, min, max) run four lanes, element k in
+//     lane k % 4, combined as (l0 + l1) + (l2 + l3) and then the tail, in
+//     both versions, so a result never depends on the CPU it ran on.
+class VECTOR_KERNELS
+{
+public:
+  enum OP
+  {
+    ADD,
+    SUBTRACT,
+    MULTIPLY,
+    DIVIDE, // the caller rules out zero divisors
+    BIT_AND,
+    BIT_OR,
+    BIT_XOR,
+    SHIFT_LEFT,
+    SHIFT_RIGHT
+  };
+
+  enum COMPARISON
+  {
+    EQUAL,
+    NOT_EQUAL,
+    LESS,
+    LESS_EQUAL,
+    GREATER,
+    GREATER_EQUAL
+  };
+
+  static void apply(OP op, const long long *x, const long long *y, long long *out, size_t n)
+  {
+#ifdef NARUTO_AVX2_KERNELS
+    if ((op == ADD || op == SUBTRACT || op == BIT_AND || op == BIT_OR || op == BIT_XOR) && has_avx2())
+      return apply_avx2(op, x, y, out, n);
+#endif
+    apply_scalar(op, x, y, out, n, 0);
+  }
+
+  static void apply(OP op, const double *x, const double *y, double *out, size_t n)
+  {
+#ifdef NARUTO_AVX2_KERNELS
+    if (has_avx2())
+      return apply_avx2(op, x, y, out, n);
+#endif
+    apply_scalar(op, x, y, out, n, 0);
+  }
+
+  // out[k] = (double)x[k]
+  static void widen(const long long *x, double *out, size_t n)
+  {
+    for (size_t k = 0; k < n; k++)
+      out[k] = (double)x[k];
+  }
+
+  // out[k] = out[k] + s * x[k], rounded after the multiply and the add
+  static void scale_add(double s, const double *x, double *out, size_t n)
+  {
+    size_t k = 0;
+#ifdef NARUTO_AVX2_KERNELS
+    if (has_avx2())
+      k = scale_add_avx2(s, x, out, n);
+#endif
+    for (; k < n; k++)
+      out[k] += s * x[k];
+  }
+
+  static void scale_add(long long s, const long long *x, long long *out, size_t n)
+  {
+    for (size_t k = 0; k < n; k++)
+      out[k] = (long long)((unsigned long long)out[k] + (unsigned long long)s * (unsigned long long)x[k]);
+  }
+
+  // out[k] = 1 when x[k] <op> y[k] holds, else 0
+  static void compare(COMPARISON op, const double *x, const double *y, unsigned char *out, size_t n)
+  {
+#ifdef NARUTO_AVX2_KERNELS
+    if (has_avx2())
+      return compare_avx2(op, x, y, out, n);
+#endif
+    compare_scalar(op, x, y, out, n, 0);
+  }
+
+  static long long sum(const long long *x, size_t n)
+  {
+#ifdef NARUTO_AVX2_KERNELS
+    if (has_avx2())
+      return sum_avx2(x, n);
+#endif
+    return sum_scalar(x, n, 0);
+  }
+
+  static double sum(const double *x, size_t n) { return dot(x, nullptr, n); }
+
+  // Sum of x[k] * y[k]; with y == nullptr, the sum of x[k]
+  static double dot(const double *x, const double *y, size_t n)
+  {
+    double lanes[4] = {0.0, 0.0, 0.0, 0.0};
+    size_t k = 0;
+#ifdef NARUTO_AVX2_KERNELS
+    if (has_avx2())
+      k = dot_avx2(x, y, n, lanes);
+#endif
+    for (; k + 4 <= n; k += 4)
+      for (size_t lane = 0; lane < 4; lane++)
+        lanes[lane] += y ? x[k + lane] * y[k + lane] : x[k + lane];
+    double total = (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+    for (; k < n; k++)
+      total += y ? x[k] * y[k] : x[k];
+    return total;
+  }
+
+  static long long dot(const long long *x, const long long *y, size_t n)
+  {
+    unsigned long long total = 0;
+    for (size_t k = 0; k < n; k++)
+      total += (unsigned long long)x[k] * (unsigned long long)y[k];
+    return (long long)total;
+  }
+
+  // Smallest (or largest) element; n > 0
+  static long long extreme(bool largest, const long long *x, size_t n)
+  {
+    long long best = x[0];
+    size_t k = 0;
+#ifdef NARUTO_AVX2_KERNELS
+    if (has_avx2())
+      k = extreme_avx2(largest, x, n, best);
+#endif
+    for (; k < n; k++)
+      if (largest ? x[k] > best : x[k] < best)
+        best = x[k];
+    return best;
+  }
+
+  // Smallest (or largest) element; n > 0. Lanes keep their value unless
+  // the new one is strictly better, as _mm256_min_pd / _mm256_max_pd do.
+  static double extreme(bool largest, const double *x, size_t n)
+  {
+    double lanes[4] = {x[0], x[0], x[0], x[0]};
+    size_t k = 0;
+#ifdef NARUTO_AVX2_KERNELS
+    if (has_avx2())
+      k = extreme_avx2(largest, x, n, lanes);
+#endif
+    for (; k + 4 <= n; k += 4)
+      for (size_t lane = 0; lane < 4; lane++)
+        lanes[lane] = better(largest, x[k + lane], lanes[lane]);
+    double best = lanes[0];
+    for (size_t lane = 1; lane < 4; lane++)
+      best = better(largest, lanes[lane], best);
+    for (; k < n; k++)
+      best = better(largest, x[k], best);
+    return best;
+  }
+
+private:
+  static double better(bool largest, double candidate, double best)
+  {
+    return (largest ? candidate > best : candidate < best) ? candidate : best;
+  }
+
+  // Wrapping int64 arithmetic, without signed overflow
+  static long long combine(OP op, long long a, long long b)
+  {
+    unsigned long long ua = (unsigned long long)a, ub = (unsigned long long)b;
+    switch (op)
+    {
+    case ADD:
+      return (long long)(ua + ub);
+    case SUBTRACT:
+      return (long long)(ua - ub);
+    case MULTIPLY:
+      return (long long)(ua * ub);
+    case DIVIDE:
+      return a / b;
+    case BIT_AND:
+      return a & b;
+    case BIT_OR:
+      return a | b;
+    case BIT_XOR:
+      return a ^ b;
+    case SHIFT_LEFT:
+      return a << b;
+    default:
+      return a >> b;
+    }
+  }
+
+  static double combine(OP op, double a, double b)
+  {
+    return op == ADD ? a + b : op == SUBTRACT ? a - b : op == MULTIPLY ? a * b : a / b;
+  }
+
+  static void compare_scalar(COMPARISON op, const double *x, const double *y, unsigned char *out, size_t n, size_t from)
+  {
+    for (size_t k = from; k < n; k++)
+    {
+      double a = x[k], b = y[k];
+      out[k] = op == EQUAL ? a == b : op == NOT_EQUAL ? a != b : op == LESS ? a < b : op == LESS_EQUAL ? a <= b : op == GREATER ? a > b : a >= b;
+    }
+  }
+
+  template <typename T>
+  static void apply_scalar(OP op, const T *x, const T *y, T *out, size_t n, size_t from)
+  {
+    for (size_t k = from; k < n; k++)
+      out[k] = combine(op, x[k], y[k]);
+  }
+
+  static long long sum_scalar(const long long *x, size_t n, size_t from)
+  {
+    unsigned long long total = 0;
+    for (size_t k = from; k < n; k++)
+      total += (unsigned long long)x[k];
+    return (long long)total;
+  }
+
+#ifdef NARUTO_AVX2_KERNELS
+  static bool has_avx2()
+  {
+    static const bool available = __builtin_cpu_supports("avx2");
+    return available;
+  }
+
+  __attribute__((target("avx2"))) static void apply_avx2(OP op, const long long *x, const long long *y, long long *out, size_t n)
+  {
+    size_t k = 0;
+    for (; k + 4 <= n; k += 4)
+    {
+      __m256i a = _mm256_loadu_si256((const __m256i *)(x + k));
+      __m256i b = _mm256_loadu_si256((const __m256i *)(y + k));
+      __m256i r = op == ADD        ? _mm256_add_epi64(a, b)
+                  : op == SUBTRACT ? _mm256_sub_epi64(a, b)
+                  : op == BIT_AND  ? _mm256_and_si256(a, b)
+                  : op == BIT_OR   ? _mm256_or_si256(a, b)
+                                   : _mm256_xor_si256(a, b);
+      _mm256_storeu_si256((__m256i *)(out + k), r);
+    }
+    apply_scalar(op, x, y, out, n, k);
+  }
+
+  __attribute__((target("avx2"))) static void apply_avx2(OP op, const double *x, const double *y, double *out, size_t n)
+  {
+    size_t k = 0;
+    for (; k + 4 <= n; k += 4)
+    {
+      __m256d a = _mm256_loadu_pd(x + k);
+      __m256d b = _mm256_loadu_pd(y + k);
+      __m256d r = op == ADD        ? _mm256_add_pd(a, b)
+                  : op == SUBTRACT ? _mm256_sub_pd(a, b)
+                  : op == MULTIPLY ? _mm256_mul_pd(a, b)
+                                   : _mm256_div_pd(a, b);
+      _mm256_storeu_pd(out + k, r);
+    }
+    apply_scalar(op, x, y, out, n, k);
+  }
+
+  __attribute__((target("avx2"))) static long long sum_avx2(const long long *x, size_t n)
+  {
+    __m256i total = _mm256_setzero_si256();
+    size_t k = 0;
+    for (; k + 4 <= n; k += 4)
+      total = _mm256_add_epi64(total, _mm256_loadu_si256((const __m256i *)(x + k)));
+    alignas(32) long long lanes[4];
+    _mm256_store_si256((__m256i *)lanes, total);
+    unsigned long long result = (unsigned long long)sum_scalar(x, n, k);
+    for (long long lane : lanes)
+      result += (unsigned long long)lane;
+    return (long long)result;
+  }
+
+  __attribute__((target("avx2"))) static void compare_avx2(COMPARISON op, const double *x, const double *y, unsigned char *out, size_t n)
+  {
+    size_t k = 0;
+    for (; k + 4 <= n; k += 4)
+    {
+      __m256d a = _mm256_loadu_pd(x + k);
+      __m256d b = _mm256_loadu_pd(y + k);
+      __m256d r = op == EQUAL        ? _mm256_cmp_pd(a, b, _CMP_EQ_OQ)
+                  : op == NOT_EQUAL  ? _mm256_cmp_pd(a, b, _CMP_NEQ_UQ)
+                  : op == LESS       ? _mm256_cmp_pd(a, b, _CMP_LT_OQ)
+                  : op == LESS_EQUAL ? _mm256_cmp_pd(a, b, _CMP_LE_OQ)
+                  : op == GREATER    ? _mm256_cmp_pd(a, b, _CMP_GT_OQ)
+                                     : _mm256_cmp_pd(a, b, _CMP_GE_OQ);
+      int bits = _mm256_movemask_pd(r);
+      for (int lane = 0; lane < 4; lane++)
+        out[k + lane] = (bits >> lane) & 1;
+    }
+    compare_scalar(op, x, y, out, n, k);
+  }
+
+  __attribute__((target("avx2"))) static size_t scale_add_avx2(double s, const double *x, double *out, size_t n)
+  {
+    __m256d scale = _mm256_set1_pd(s);
+    size_t k = 0;
+    for (; k + 4 <= n; k += 4)
+      _mm256_storeu_pd(out + k, _mm256_add_pd(_mm256_loadu_pd(out + k), _mm256_mul_pd(scale, _mm256_loadu_pd(x + k))));
+    return k;
+  }
+
+  // Whole groups of four into lanes; returns how many elements it took
+  __attribute__((target("avx2"))) static size_t dot_avx2(const double *x, const double *y, size_t n, double *lanes)
+  {
+    __m256d total = _mm256_setzero_pd();
+    size_t k = 0;
+    for (; k + 4 <= n; k += 4)
+    {
+      __m256d a = _mm256_loadu_pd(x + k);
+      total = _mm256_add_pd(total, y ? _mm256_mul_pd(a, _mm256_loadu_pd(y + k)) : a);
+    }
+    _mm256_storeu_pd(lanes, total);
+    return k;
+  }
+
+  __attribute__((target("avx2"))) static size_t extreme_avx2(bool largest, const long long *x, size_t n, long long &best)
+  {
+    __m256i lanes = _mm256_set1_epi64x(best);
+    size_t k = 0;
+    for (; k + 4 <= n; k += 4)
+    {
+      __m256i a = _mm256_loadu_si256((const __m256i *)(x + k));
+      __m256i take = largest ? _mm256_cmpgt_epi64(a, lanes) : _mm256_cmpgt_epi64(lanes, a);
+      lanes = _mm256_blendv_epi8(lanes, a, take);
+    }
+    alignas(32) long long values[4];
+    _mm256_store_si256((__m256i *)values, lanes);
+    for (long long value : values)
+      if (largest ? value > best : value < best)
+        best = value;
+    return k;
+  }
+
+  __attribute__((target("avx2"))) static size_t extreme_avx2(bool largest, const double *x, size_t n, double *lanes)
+  {
+    __m256d best = _mm256_loadu_pd(lanes);
+    size_t k = 0;
+    for (; k + 4 <= n; k += 4)
+    {
+      __m256d a = _mm256_loadu_pd(x + k);
+      best = largest ? _mm256_max_pd(a, best) : _mm256_min_pd(a, best);
+    }
+    _mm256_storeu_pd(lanes, best);
+    return k;
+  }
+#endif
+};
+
+#endif
@@ -0,0 +1,183 @@
+#ifndef __VECTOR_LOOP_H
+#define __VECTOR_LOOP_H
+
+#include "ast.hpp"
+#include <string>
+#include <vector>
+
+// A counted loop (counted_step +1, bound by < or <=) whose body is one
+// element-wise statement over numeric arrays:
+//
+//   c[i] = E;                  MAP
+//   s = s + E;  or  s += E;    SUM
+//
+// where E is built with +, - and * from a[i], i itself, numeric literals
+// and variables the body never writes. Found by OPTIMIZER once the body is
+// folded; the interpreter checks the runtime types (unboxed int/float
+// arrays long enough for the whole range, int/float scalars) and runs the
+// loop block by block with VECTOR_KERNELS, or falls back to the plain loop.
+// '/' is left out: a zero divisor has to stop at its own iteration.
+struct VECTOR_LOOP
+{
+  enum KIND
+  {
+    MAP,
+    SUM
+  } kind;
+
+  // E flattened, operands before the operation using them; the last node
+  // is E itself
+  struct NODE
+  {
+    enum OP
+    {
+      ELEMENT, // a[i]: name is a
+      COUNTER, // i
+      VALUE,   // a literal or an invariant variable, evaluated once
+      ADD,
+      SUBTRACT,
+      MULTIPLY
+    } op;
+    std::string name;
+    EXPRESSION *value = nullptr; // VALUE
+    int left = -1, right = -1;   // ADD, SUBTRACT, MULTIPLY
+  };
+
+  std::string counter;
+  std::string target; // c for MAP, s for SUM
+  std::vector<NODE> nodes;
+
+  // nullptr unless stmt has one of the shapes above
+  static VECTOR_LOOP *plan(FOR_STATEMENT *stmt)
+  {
+    if (stmt->counted_step != 1)
+      return nullptr;
+    auto condition = static_cast<BINARY_EXPRESSION *>(stmt->condition);
+    if (condition->operator_token.TYPE != TOKEN_LESS_THAN && condition->operator_token.TYPE != TOKEN_LESS_EQUAL)
+      return nullptr;
+
+    STATEMENT *body = stmt->body;
+    if (body->kind == NODE_BLOCK_STATEMENT)
+    {
+      auto block = static_cast<BLOCK_STATEMENT *>(body);
+      if (block->statements.size() != 1)
+        return nullptr;
+      body = block->statements[0];
+    }
+    if (body->kind != NODE_EXPRESSION_STATEMENT)
+      return nullptr;
+
+    VECTOR_LOOP loop;
+    loop.counter = static_cast<VARIABLE_DECLARATION_STATEMENT *>(stmt->initializer)->name_token.VALUE;
+    EXPRESSION *expr = static_cast<EXPRESSION_STATEMENT *>(body)->expression;
+    EXPRESSION *element_expr = nullptr;
+    if (expr->kind == NODE_ARRAY_ASSIGNMENT_EXPRESSION)
+    {
+      auto assign = static_cast<ARRAY_ASSIGNMENT_EXPRESSION *>(expr);
+      if (!is_name(assign->array_expression) || !is_variable(assign->index_expression, loop.counter))
+        return nullptr;
+      loop.kind = MAP;
+      loop.target = name_of(assign->array_expression);
+      element_expr = assign->value_expression;
+    }
+    else if (expr->kind == NODE_ASSIGNMENT_EXPRESSION)
+    {
+      auto assign = static_cast<ASSIGNMENT_EXPRESSION *>(expr);
+      if (assign->value_expression->kind != NODE_BINARY_EXPRESSION)
+        return nullptr;
+      auto sum = static_cast<BINARY_EXPRESSION *>(assign->value_expression);
+      if (sum->operator_token.TYPE != TOKEN_PLUS || !is_variable(sum->left_operand, assign->variable_name.VALUE))
+        return nullptr;
+      loop.kind = SUM;
+      loop.target = assign->variable_name.VALUE;
+      element_expr = sum->right_operand;
+    }
+    else if (expr->kind == NODE_COMPOUND_ASSIGNMENT_EXPRESSION)
+    {
+      auto compound = static_cast<COMPOUND_ASSIGNMENT_EXPRESSION *>(expr);
+      if (compound->operator_token.TYPE != TOKEN_PLUS || !is_name(compound->target))
+        return nullptr;
+      loop.kind = SUM;
+      loop.target = name_of(compound->target);
+      element_expr = compound->value_expression;
+    }
+    else
+      return nullptr;
+
+    // The running sum must not feed E or the bound
+    if (loop.target == loop.counter || (loop.kind == SUM && is_variable(condition->right_operand, loop.target)))
+      return nullptr;
+    if (loop.add(element_expr) < 0)
+      return nullptr;
+    return new VECTOR_LOOP(std::move(loop));
+  }
+
+private:
+  static bool is_name(EXPRESSION *expr) { return expr->kind == NODE_VARIABLE_EXPRESSION; }
+  static const std::string &name_of(EXPRESSION *expr) { return static_cast<VARIABLE_EXPRESSION *>(expr)->name.VALUE; }
+  static bool is_variable(EXPRESSION *expr, const std::string &name) { return is_name(expr) && name_of(expr) == name; }
+
+  // Appends E's nodes; the index of E's own node, or -1 if E does not fit
+  int add(EXPRESSION *expr)
+  {
+    NODE node;
+    switch (expr->kind)
+    {
+    case NODE_ARRAY_ACCESS_EXPRESSION:
+    {
+      auto access = static_cast<ARRAY_ACCESS_EXPRESSION *>(expr);
+      if (!is_name(access->array_expression) || !is_variable(access->index_expression, counter) ||
+          (kind == SUM && name_of(access->array_expression) == target))
+        return -1;
+      node.op = NODE::ELEMENT;
+      node.name = name_of(access->array_expression);
+      break;
+    }
+    case NODE_VARIABLE_EXPRESSION:
+      if (name_of(expr) == counter)
+        node.op = NODE::COUNTER;
+      else if (kind == SUM && name_of(expr) == target)
+        return -1;
+      else
+      {
+        node.op = NODE::VALUE;
+        node.name = name_of(expr);
+        node.value = expr;
+      }
+      break;
+    case NODE_LITERAL_EXPRESSION:
+    {
+      enum type literal = static_cast<LITERAL_EXPRESSION *>(expr)->token.TYPE;
+      if (literal != TOKEN_INT_LITERAL && literal != TOKEN_FLOAT_LITERAL)
+        return -1;
+      node.op = NODE::VALUE;
+      node.value = expr;
+      break;
+    }
+    case NODE_BINARY_EXPRESSION:
+    {
+      auto binary = static_cast<BINARY_EXPRESSION *>(expr);
+      enum type op = binary->operator_token.TYPE;
+      if (op == TOKEN_PLUS)
+        node.op = NODE::ADD;
+      else if (op == TOKEN_MINUS)
+        node.op = NODE::SUBTRACT;
+      else if (op == TOKEN_ASTERISK)
+        node.op = NODE::MULTIPLY;
+      else
+        return -1;
+      node.left = add(binary->left_operand);
+      node.right = node.left < 0 ? -1 : add(binary->right_operand);
+      if (node.right < 0)
+        return -1;
+      break;
+    }
+    default:
+      return -1;
+    }
+    nodes.push_back(node);
+    return (int)nodes.size() - 1;
+  }
+};
+
+#endif
@@ -0,0 +1,159 @@
+#ifndef __WORK_STEALING_POOL_H
+#define __WORK_STEALING_POOL_H
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// The threads behind parallel for loops. run(count, task) calls
+// task(t, worker) once for every t in [0, count) and returns when all have
+// finished. The tasks are dealt out up front, one contiguous range per
+// worker; a worker takes tasks from the front of its own range and, once
+// that is empty, steals the back half of another's, so uneven tasks still
+// keep every thread busy until the end. The calling thread is worker 0.
+//
+// One pool serves the whole program: its threads start on first use and
+// then sleep between batches instead of being created for every loop.
+class WORK_STEALING_POOL
+{
+public:
+  // The pool, sized by threads() on first use
+  static WORK_STEALING_POOL &instance()
+  {
+    static WORK_STEALING_POOL *pool = new WORK_STEALING_POOL(threads()); // never destroyed: its threads never exit
+    return *pool;
+  }
+
+  // Number of workers, the hardware's unless set (--threads=N) before the
+  // first parallel loop
+  static size_t &threads()
+  {
+    static size_t count = std::max(1u, std::thread::hardware_concurrency());
+    return count;
+  }
+
+  size_t size() const { return ranges.size(); }
+
+  void run(size_t count, const std::function<void(size_t, size_t)> &task)
+  {
+    size_t n = size();
+    for (size_t w = 0; w < n; w++)
+    {
+      std::lock_guard<std::mutex> hold(ranges[w]->lock);
+      ranges[w]->front = count * w / n;
+      ranges[w]->back = count * (w + 1) / n;
+    }
+    if (n == 1)
+    {
+      work(0, task);
+      return;
+    }
+
+    {
+      std::lock_guard<std::mutex> hold(batch_lock);
+      current = &task;
+      busy = n - 1;
+      batch++;
+    }
+    batch_ready.notify_all();
+    work(0, task);
+
+    std::unique_lock<std::mutex> hold(batch_lock);
+    batch_done.wait(hold, [this]() { return busy == 0; });
+    current = nullptr;
+  }
+
+private:
+  struct RANGE
+  {
+    std::mutex lock;
+    size_t front = 0, back = 0; // tasks [front, back) not yet taken
+  };
+  std::vector<std::unique_ptr<RANGE>> ranges;
+
+  std::mutex batch_lock;
+  std::condition_variable batch_ready, batch_done;
+  const std::function<void(size_t, size_t)> *current = nullptr;
+  size_t batch = 0; // batches started so far
+  size_t busy = 0;  // helper threads still working on the current batch
+
+  explicit WORK_STEALING_POOL(size_t n)
+  {
+    for (size_t w = 0; w < n; w++)
+      ranges.push_back(std::make_unique<RANGE>());
+    for (size_t w = 1; w < n; w++)
+      std::thread([this, w]() { helper(w); }).detach();
+  }
+
+  void helper(size_t worker)
+  {
+    size_t seen = 0;
+    while (true)
+    {
+      const std::function<void(size_t, size_t)> *task;
+      {
+        std::unique_lock<std::mutex> hold(batch_lock);
+        batch_ready.wait(hold, [&]() { return batch != seen; });
+        seen = batch;
+        task = current;
+      }
+      work(worker, *task);
+      {
+        std::lock_guard<std::mutex> hold(batch_lock);
+        if (--busy == 0)
+          batch_done.notify_one();
+      }
+    }
+  }
+
+  void work(size_t worker, const std::function<void(size_t, size_t)> &task)
+  {
+    size_t t;
+    while (take(worker, t) || steal(worker, t))
+      task(t, worker);
+  }
+
+  bool take(size_t worker, size_t &t)
+  {
+    RANGE &own = *ranges[worker];
+    std::lock_guard<std::mutex> hold(own.lock);
+    if (own.front == own.back)
+      return false;
+    t = own.front++;
+    return true;
+  }
+
+  // Moves the back half of the first non-empty range after ours into ours
+  // and takes its first task
+  bool steal(size_t thief, size_t &t)
+  {
+    size_t n = size();
+    for (size_t k = 1; k < n; k++)
+    {
+      RANGE &victim = *ranges[(thief + k) % n];
+      size_t first, last;
+      {
+        std::lock_guard<std::mutex> hold(victim.lock);
+        if (victim.front == victim.back)
+          continue;
+        last = victim.back;
+        first = last - (last - victim.front + 1) / 2;
+        victim.back = first;
+      }
+      RANGE &own = *ranges[thief];
+      std::lock_guard<std::mutex> hold(own.lock);
+      own.front = first + 1;
+      own.back = last;
+      t = first;
+      return true;
+    }
+    return false;
+  }
+};
+
+#endif
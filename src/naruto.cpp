@@ -7,22 +7,69 @@
 #include "headers/ast.hpp"
 #include "headers/parser.hpp"
 #include "headers/type_checker.hpp"
+#include "headers/optimizer.hpp"
+#include "headers/range_analysis.hpp"
 #include "headers/interpreter.hpp"
+#include "headers/output_writer.hpp"
+#include "headers/work_stealing_pool.hpp"
 
 int main(int argc, char *argv[])
 {
-  if (argc < 2)
+  const char *usage = "Usage: naruto [--flush=line|block|interactive|async] [--max-output=BYTES] [--threads=N] <file.nt>";
+  OUTPUT_WRITER::FLUSH_MODE flushMode = OUTPUT_WRITER::FLUSH_LINE;
+  unsigned long long maxOutputBytes = 0;
+  const char *sourcePath = nullptr;
+
+  for (int i = 1; i < argc; i++)
+  {
+    std::string arg = argv[i];
+    if (arg.rfind("--flush=", 0) == 0)
+    {
+      if (!OUTPUT_WRITER::parse_mode(arg.substr(8), flushMode))
+      {
+        std::cerr << "Unknown flush mode: " << arg.substr(8) << std::endl;
+        exit(1);
+      }
+    }
+    else if (arg.rfind("--max-output=", 0) == 0)
+    {
+      std::string bytes = arg.substr(13);
+      if (bytes.empty() || bytes.find_first_not_of("0123456789") != std::string::npos)
+      {
+        std::cerr << "Invalid --max-output value: " << bytes << std::endl;
+        exit(1);
+      }
+      maxOutputBytes = std::stoull(bytes);
+    }
+    else if (arg.rfind("--threads=", 0) == 0)
+    {
+      std::string count = arg.substr(10);
+      if (count.empty() || count.size() > 4 || count.find_first_not_of("0123456789") != std::string::npos || std::stoi(count) < 1)
+      {
+        std::cerr << "Invalid --threads value: " << count << std::endl;
+        exit(1);
+      }
+      WORK_STEALING_POOL::threads() = std::stoi(count); // threads for parallel for loops
+    }
+    else
+      sourcePath = argv[i];
+  }
+
+  if (!sourcePath)
   {
-    std::cout << "Usage: naruto <file.nt>";
+    std::cout << usage;
     exit(1);
   }
-  std::ifstream sourceFileStream(argv[1]);
+  std::ifstream sourceFileStream(sourcePath);
   if (!sourceFileStream.is_open())
   {
-    std::cerr << "Could not open file: " << argv[1] << std::endl;
+    std::cerr << "Could not open file: " << sourcePath << std::endl;
     exit(1);
   }
 
+  // All std::cout output from here on goes through the buffered writer
+  OUTPUT_WRITER::install(flushMode, maxOutputBytes);
+
   std::stringstream buffer;
   char temp;
   while (sourceFileStream.get(temp))
@@ -41,11 +88,20 @@ int main(int argc, char *argv[])
   TYPE_CHECKER typeChecker;
   typeChecker.analyze(programAST);
 
-  // 4. INTERPRETER (The Runtime)
+  // 4. OPTIMIZER (Constant folding & dead-code elimination)
+  OPTIMIZER optimizer;
+  programAST = optimizer.optimize(programAST);
+
+  // 5. RANGE ANALYSIS (Bounds checks provable ahead of time)
+  RANGE_ANALYSIS rangeAnalysis;
+  rangeAnalysis.analyze(programAST);
+
+  // 6. INTERPRETER (The Runtime)
   std::cout << "\n--- PROGRAM OUTPUT ---\n";
 
   INTERPRETER interpreter;
   interpreter.execute(programAST);
 
+  std::cout.flush();
   return 0;
 }
\ No newline at end of file